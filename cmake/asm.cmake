@@ -1,3 +1,31 @@
+if (WITH_ASM AND XMRIG_X86 AND CMAKE_SIZEOF_VOID_P EQUAL 8)
+    set(XMRIG_ASM_LIBRARY "xmrig-asm")
+
+    if (CMAKE_C_COMPILER_ID MATCHES MSVC)
+        enable_language(ASM_MASM)
+
+        set(XMRIG_ASM_FILES
+            "src/crypto/asm/cn_main_loop.asm"
+            "src/crypto/asm/CryptonightR_template.asm"
+        )
+
+        set_property(SOURCE ${XMRIG_ASM_FILES} PROPERTY ASM_MASM)
+    else()
+        enable_language(ASM)
+
+        set(XMRIG_ASM_FILES
+            "src/crypto/asm/cn_main_loop.S"
+            "src/crypto/asm/CryptonightR_template.S"
+        )
+
+        set_property(SOURCE ${XMRIG_ASM_FILES} PROPERTY C)
+    endif()
+
+    add_library(${XMRIG_ASM_LIBRARY} STATIC ${XMRIG_ASM_FILES})
+    set(XMRIG_ASM_SOURCES src/crypto/Asm.h src/crypto/Asm.cpp src/crypto/CryptonightR_gen.cpp)
+    set_property(TARGET ${XMRIG_ASM_LIBRARY} PROPERTY LINKER_LANGUAGE C)
+else()
     set(XMRIG_ASM_SOURCES "")
     set(XMRIG_ASM_LIBRARY "")
     add_definitions(/DXMRIG_NO_ASM)
+endif()
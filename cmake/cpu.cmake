@@ -3,18 +3,47 @@ if (NOT CMAKE_SYSTEM_PROCESSOR)
 endif()
 
 
-if (CMAKE_SYSTEM_PROCESSOR MATCHES "^(x86_64|AMD64)$")
-    add_definitions(/DRAPIDJSON_SSE2)
+if (NOT CPU_BACKEND OR CPU_BACKEND STREQUAL "auto")
+    if (ARM_TARGET EQUAL 7 OR CMAKE_SYSTEM_PROCESSOR MATCHES "^(armv7|armv7f|armv7s|armv7k|armv7-a|armv7l)$")
+        set(CPU_BACKEND armv7)
+    elseif (ARM_TARGET EQUAL 8 OR CMAKE_SYSTEM_PROCESSOR MATCHES "^(aarch64|arm64|armv8-a)$")
+        set(CPU_BACKEND aarch64)
+    elseif (CMAKE_SYSTEM_PROCESSOR MATCHES "^(ppc64le|ppc64|powerpc64le|powerpc64)$")
+        set(CPU_BACKEND ppc64le)
+    else()
+        set(CPU_BACKEND x86_64)
+    endif()
 endif()
 
-if (NOT ARM_TARGET)
-    if (CMAKE_SYSTEM_PROCESSOR MATCHES "^(aarch64|arm64|armv8-a)$")
-        set(ARM_TARGET 8)
-    elseif (CMAKE_SYSTEM_PROCESSOR MATCHES "^(armv7|armv7f|armv7s|armv7k|armv7-a|armv7l)$")
-        set(ARM_TARGET 7)
-    endif()
+
+if (CPU_BACKEND STREQUAL "x86_64")
+    set(XMRIG_X86 ON)
+    add_definitions(/DRAPIDJSON_SSE2)
+
+    set(XMRIG_CPU_FLAGS "-maes")
+elseif (CPU_BACKEND STREQUAL "ppc64le")
+    set(XMRIG_PPC64   ON)
+    set(WITH_LIBCPUID OFF)
+    add_definitions(/DXMRIG_PPC64)
+
+    set(XMRIG_CPU_FLAGS "-mcpu=native -mtune=native -mvsx")
+elseif (CPU_BACKEND STREQUAL "ref")
+    set(XMRIG_REF     ON)
+    set(WITH_LIBCPUID OFF)
+    add_definitions(/DXMRIG_REF)
+
+    set(XMRIG_CPU_FLAGS "")
+elseif (CPU_BACKEND STREQUAL "aarch64")
+    set(ARM_TARGET 8)
+elseif (CPU_BACKEND STREQUAL "armv7")
+    set(ARM_TARGET 7)
+else()
+    message(FATAL_ERROR "Unsupported CPU_BACKEND \"${CPU_BACKEND}\", use x86_64, ppc64le, aarch64, armv7 or ref")
 endif()
 
+message(STATUS "Use CPU_BACKEND=${CPU_BACKEND} (${CMAKE_SYSTEM_PROCESSOR})")
+
+
 if (ARM_TARGET AND ARM_TARGET GREATER 6)
     set(XMRIG_ARM     ON)
     set(WITH_LIBCPUID OFF)
@@ -36,8 +65,12 @@ if (ARM_TARGET AND ARM_TARGET GREATER 6)
         else()
             set(ARM8_CXX_FLAGS "-march=armv8-a")
         endif()
+
+        set(XMRIG_CPU_FLAGS "${ARM8_CXX_FLAGS}")
     elseif (ARM_TARGET EQUAL 7)
         set(XMRIG_ARMv7 ON)
         add_definitions(/DXMRIG_ARMv7)
+
+        set(XMRIG_CPU_FLAGS "-mfpu=neon")
     endif()
 endif()
@@ -12,11 +12,15 @@ endif()
 
 if (CMAKE_CXX_COMPILER_ID MATCHES GNU)
 
-    set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -Wall -Wno-strict-aliasing -flax-vector-conversions -fpermissive ")
-    set(CMAKE_C_FLAGS_RELEASE "${CMAKE_C_FLAGS_RELEASE} -Ofast -mcpu=native -mtune=native -mvsx")
+    set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -Wall -Wno-strict-aliasing -flax-vector-conversions ${XMRIG_CPU_FLAGS}")
+    set(CMAKE_C_FLAGS_RELEASE "${CMAKE_C_FLAGS_RELEASE} -Ofast")
 
-    set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -Wall -fno-exceptions -fno-rtti -Wno-class-memaccess -flax-vector-conversions -fpermissive")
-    set(CMAKE_CXX_FLAGS_RELEASE "${CMAKE_CXX_FLAGS_RELEASE} -s -Ofast -mcpu=native -mtune=native -mvsx")
+    set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -Wall -fno-exceptions -fno-rtti -Wno-class-memaccess -flax-vector-conversions -fpermissive ${XMRIG_CPU_FLAGS}")
+    set(CMAKE_CXX_FLAGS_RELEASE "${CMAKE_CXX_FLAGS_RELEASE} -s -Ofast")
+
+    if (XMRIG_X86)
+        add_definitions(/DHAVE_ROTR)
+    endif()
 
     add_definitions(/D_GNU_SOURCE)
 
@@ -28,10 +32,15 @@ if (CMAKE_CXX_COMPILER_ID MATCHES GNU)
 
 elseif (CMAKE_CXX_COMPILER_ID MATCHES Clang)
 
-    set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -Wc++11-narrowing -fpermissive -flax-vector-conversions")
-    set(CMAKE_C_FLAGS_RELEASE "${CMAKE_C_FLAGS_RELEASE} -Ofast -funroll-loops -fmerge-all-constants -mcpu=native -mtune=native -mvsx")
+    set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -Wc++11-narrowing -flax-vector-conversions ${XMRIG_CPU_FLAGS}")
+    set(CMAKE_C_FLAGS_RELEASE "${CMAKE_C_FLAGS_RELEASE} -Ofast -funroll-loops -fmerge-all-constants")
 
-    set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -Wc++11-narrowing -fpermissive -fno-rtti -Wno-missing-braces -flax-vector-conversions")
-    set(CMAKE_CXX_FLAGS_RELEASE "${CMAKE_CXX_FLAGS_RELEASE} -Ofast -funroll-loops -fmerge-all-constants -mcpu=native -mtune=native -mvsx")
+    set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -Wc++11-narrowing -fpermissive -fno-rtti -Wno-missing-braces -flax-vector-conversions ${XMRIG_CPU_FLAGS}")
+    set(CMAKE_CXX_FLAGS_RELEASE "${CMAKE_CXX_FLAGS_RELEASE} -Ofast -funroll-loops -fmerge-all-constants")
+
+endif()
 
+if (CMAKE_CXX_COMPILER_ID MATCHES GNU OR CMAKE_CXX_COMPILER_ID MATCHES Clang)
+    # The reference Groestl permutes its byte state through uint32_t pointers in every round.
+    set_source_files_properties(src/crypto/c_groestl.c PROPERTIES COMPILE_FLAGS -fno-strict-aliasing)
 endif()
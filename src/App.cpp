@@ -90,7 +90,8 @@ int xmrig::App::exec()
 
     background();
 
-    Mem::init(m_controller->config()->isHugePages());
+    const xmrig::Config *config = m_controller->config();
+    Mem::init(config->isHugePages(), config->isGigantPages(), config->scratchpadOffset(), config->hugetlbfs());
 
     Summary::print(m_controller);
 
@@ -24,7 +24,12 @@
  */
 
 
+#include <algorithm>
+
+
+#include "common/cpu/Numa.h"
 #include "common/utils/mm_malloc.h"
+#include "crypto/CnRCache.h"
 #include "crypto/CryptoNight.h"
 #include "crypto/CryptoNight_constants.h"
 #include "Mem.h"
@@ -32,28 +37,40 @@
 
 bool Mem::m_enabled = true;
 int Mem::m_flags    = 0;
+size_t Mem::m_offset = 0;
+
+
+// Contexts of one worker live next to each other in a single block, each on its own cache lines.
+static constexpr const size_t kCtxAlign  = 64;
+static constexpr const size_t kCtxStride = (sizeof(cryptonight_ctx) + kCtxAlign - 1) & ~(kCtxAlign - 1);
 
 
-MemInfo Mem::create(cryptonight_ctx **ctx, xmrig::Algo algorithm, size_t count)
+/**
+ * Allocates scratchpads for count hashes of the algorithm, if memory is larger than the algorithm needs per
+ * scratchpad the block is sized for it instead, so carve() can later switch to a bigger algorithm in place.
+ */
+MemInfo Mem::create(cryptonight_ctx **ctx, xmrig::Algo algorithm, size_t count, size_t memory)
 {
     using namespace xmrig;
 
     MemInfo info;
-    info.size = cn_select_memory(algorithm) * count;
+    info.size = (std::max(cn_select_memory(algorithm), memory) + (count > 1 ? m_offset : 0)) * count;
 
     constexpr const size_t align_size = 2 * 1024 * 1024;
     info.size  = ((info.size + align_size - 1) / align_size) * align_size;
     info.pages = info.size / align_size;
 
     allocate(info, m_enabled);
+    info.node = xmrig::Numa::node(info.memory);
 
-    for (size_t i = 0; i < count; ++i) {
-        cryptonight_ctx *c = static_cast<cryptonight_ctx *>(malloc(sizeof(cryptonight_ctx)));
-        c->memory          = info.memory + (i * cn_select_memory(algorithm));
+    uint8_t *block = static_cast<uint8_t *>(_mm_malloc(kCtxStride * count, kCtxAlign));
 
-        uint8_t* p = reinterpret_cast<uint8_t*>(allocateExecutableMemory(0x4000));
-        c->generated_code  = reinterpret_cast<cn_mainloop_fun_ms_abi>(p);
-        c->generated_code_double = reinterpret_cast<cn_mainloop_double_fun_ms_abi>(p + 0x2000);
+    for (size_t i = 0; i < count; ++i) {
+        cryptonight_ctx *c = reinterpret_cast<cryptonight_ctx *>(block + i * kCtxStride);
+        c->abort           = nullptr;
+        c->sequence        = 0;
+        c->generated_code  = nullptr;
+        c->generated_code_double = nullptr;
 
         c->generated_code_data.variant = xmrig::VARIANT_MAX;
         c->generated_code_data.height = (uint64_t)(-1);
@@ -62,16 +79,55 @@ MemInfo Mem::create(cryptonight_ctx **ctx, xmrig::Algo algorithm, size_t count)
         ctx[i] = c;
     }
 
+    carve(ctx, algorithm, count, info);
+
     return info;
 }
 
 
+bool Mem::carve(cryptonight_ctx **ctx, xmrig::Algo algorithm, size_t count, const MemInfo &info)
+{
+    // With a non zero offset scratchpad i starts i * offset bytes later than the plain layout, so the random
+    // accesses of the N hashes of one thread don't compete for the same cache sets.
+    const size_t memory = xmrig::cn_select_memory(algorithm);
+    const size_t stride = memory + (count > 1 ? m_offset : 0);
+
+    if (memory == 0 || stride * count > info.size) {
+        return false;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        ctx[i]->memory = info.memory + (i * stride);
+    }
+
+    return true;
+}
+
+
+const char *Mem::tierName(MemInfo::Tier tier)
+{
+    static const char *names[MemInfo::TierMax] = { "4K", "THP", "2M", "1G" };
+
+    return tier < MemInfo::TierMax ? names[tier] : "4K";
+}
+
+
 void Mem::release(cryptonight_ctx **ctx, size_t count, MemInfo &info)
 {
     release(info);
 
     for (size_t i = 0; i < count; ++i) {
-        free(ctx[i]);
+        xmrig::CnRCache::release(reinterpret_cast<const void *>(ctx[i]->generated_code));
+        xmrig::CnRCache::release(reinterpret_cast<const void *>(ctx[i]->generated_code_double));
+        xmrig::CnRCache::release(ctx[i]->v4jit);
+    }
+
+    if (count > 0) {
+        _mm_free(ctx[0]);
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        ctx[i] = nullptr;
     }
 }
 
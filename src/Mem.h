@@ -39,11 +39,22 @@ struct cryptonight_ctx;
 
 struct MemInfo
 {
+    // Page size backing the scratchpads, in order of preference: 1 GB, 2 MB, transparent huge pages, regular pages.
+    enum Tier {
+        Tier4K,
+        TierTHP,
+        Tier2M,
+        Tier1G,
+        TierMax
+    };
+
     alignas(16) uint8_t *memory;
 
     size_t hugePages;
     size_t pages;
     size_t size;
+    Tier tier;
+    int node;
 };
 
 
@@ -53,15 +64,22 @@ public:
     enum Flags {
         HugepagesAvailable = 1,
         HugepagesEnabled   = 2,
-        Lock               = 4
+        Lock               = 4,
+        GigantPages        = 8
     };
 
-    static MemInfo create(cryptonight_ctx **ctx, xmrig::Algo algorithm, size_t count);
-    static void init(bool enabled);
+    static MemInfo create(cryptonight_ctx **ctx, xmrig::Algo algorithm, size_t count, size_t memory = 0);
+    static const char *tierName(MemInfo::Tier tier);
+    static bool carve(cryptonight_ctx **ctx, xmrig::Algo algorithm, size_t count, const MemInfo &info);
+    static void init(bool enabled, bool gigantPages = false, size_t offset = 0, const char *persistent = nullptr);
     static void release(cryptonight_ctx **ctx, size_t count, MemInfo &info);
+    static void removeStaleFiles();
 
+    // Returns nullptr on failure on every platform.
     static void *allocateExecutableMemory(size_t size);
     static void protectExecutableMemory(void *p, size_t size);
+    static void unprotectExecutableMemory(void *p, size_t size);
+    static void releaseExecutableMemory(void *p, size_t size);
     static void flushInstructionCache(void *p, size_t size);
 
     static inline bool isHugepagesAvailable() { return (m_flags & HugepagesAvailable) != 0; }
@@ -70,8 +88,17 @@ private:
     static void allocate(MemInfo &info, bool enabled);
     static void release(MemInfo &info);
 
+#   ifdef __linux__
+    static bool allocateGigant(MemInfo &info);
+    static bool allocatePersistent(MemInfo &info);
+    static bool releasePersistent(MemInfo &info);
+    static void removeStalePersistent();
+    static void releaseGigant(MemInfo &info);
+#   endif
+
     static int m_flags;
     static bool m_enabled;
+    static size_t m_offset;
 };
 
 
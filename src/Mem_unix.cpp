@@ -24,10 +24,27 @@
  */
 
 
+#include <errno.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/mman.h>
 
 
+#ifdef __linux__
+#   include <dirent.h>
+#   include <fcntl.h>
+#   include <map>
+#   include <mutex>
+#   include <sys/file.h>
+#   include <sys/stat.h>
+#   include <sys/vfs.h>
+#   include <unistd.h>
+#endif
+
+
+#include "base/tools/String.h"
+#include "common/cpu/Numa.h"
 #include "common/log/Log.h"
 #include "common/utils/mm_malloc.h"
 #include "common/xmrig.h"
@@ -35,15 +52,161 @@
 #include "Mem.h"
 
 
-void Mem::init(bool enabled)
+#ifdef __linux__
+#ifndef MAP_HUGE_SHIFT
+#   define MAP_HUGE_SHIFT 26
+#endif
+
+#ifndef MAP_HUGE_1GB
+#   define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+
+
+namespace {
+
+static constexpr const size_t kGigantPageSize = 1024U * 1024U * 1024U;
+static constexpr const size_t kHugePageSize   = 2U * 1024U * 1024U;
+
+
+// One gigantic page mapping per NUMA node, worker scratchpads are carved from it sequentially
+// and the mapping is dropped when the last of them is released.
+struct GigantPool
+{
+    uint8_t *memory = nullptr;
+    size_t size     = 0;
+    size_t offset   = 0;
+    size_t refs     = 0;
+};
+
+
+static std::map<int, GigantPool> pools;
+static std::mutex poolsMutex;
+
+
+// Scratchpads backed by files in a hugetlbfs (or tmpfs) directory, they outlive the process so a restarted
+// miner maps the already allocated and faulted pages again instead of building them from scratch.
+struct PersistentFile
+{
+    int fd      = -1;
+    size_t size = 0;
+};
+
+
+static constexpr const size_t kMaxPersistentFiles = 1024;
+static constexpr const long kHugetlbfsMagic       = 0x958458f6;
+
+static std::map<const uint8_t *, PersistentFile> persistentFiles;
+static xmrig::String persistentPath;
+
+
+static constexpr const size_t kGuardSize = 4096;
+
+
+// Sums AnonHugePages of the mappings that lie within [memory, memory + size), the kernel is free to back
+// MADV_HUGEPAGE memory with regular pages so this is the only way to know what was actually received.
+static size_t anonHugePages(const uint8_t *memory, size_t size)
+{
+    FILE *fp = fopen("/proc/self/smaps", "r");
+    if (!fp) {
+        return 0;
+    }
+
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(memory);
+    const uintptr_t end   = begin + size;
+
+    char line[256];
+    bool inside  = false;
+    size_t bytes = 0;
+
+    while (fgets(line, sizeof(line), fp)) {
+        unsigned long long from = 0;
+        unsigned long long to   = 0;
+        unsigned long long kb   = 0;
+
+        if (sscanf(line, "%llx-%llx ", &from, &to) == 2) {
+            inside = from >= begin && to <= end;
+        }
+        else if (inside && sscanf(line, "AnonHugePages: %llu kB", &kb) == 1) {
+            bytes += static_cast<size_t>(kb) * 1024;
+        }
+    }
+
+    fclose(fp);
+
+    return bytes / kHugePageSize;
+}
+
+
+// 2 MB aligned anonymous mapping with MADV_HUGEPAGE, followed by an inaccessible guard page so the kernel
+// never merges it with the scratchpad of another thread and smaps can be attributed per thread.
+static uint8_t *allocateTHP(size_t size)
+{
+#   ifdef MADV_HUGEPAGE
+    const size_t total = size + kHugePageSize;
+    uint8_t *raw = static_cast<uint8_t*>(mmap(0, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    if (raw == MAP_FAILED) {
+        return nullptr;
+    }
+
+    uint8_t *memory   = reinterpret_cast<uint8_t*>((reinterpret_cast<uintptr_t>(raw) + kHugePageSize - 1) & ~(kHugePageSize - 1));
+    const size_t head = static_cast<size_t>(memory - raw);
+    const size_t tail = total - head - size - kGuardSize;
+
+    if (head) {
+        munmap(raw, head);
+    }
+
+    if (tail) {
+        munmap(memory + size + kGuardSize, tail);
+    }
+
+    if (madvise(memory, size, MADV_HUGEPAGE) != 0 || mprotect(memory + size, kGuardSize, PROT_NONE) != 0) {
+        munmap(memory, size + kGuardSize);
+        return nullptr;
+    }
+
+    // Pre-fault, the first write to every 2 MB range is what makes the kernel pick a huge page for it.
+    for (size_t i = 0; i < size; i += 4096) {
+        memory[i] = 0;
+    }
+
+    return memory;
+#   else
+    return nullptr;
+#   endif
+}
+
+} // namespace
+#endif
+
+
+void Mem::init(bool enabled, bool gigantPages, size_t offset, const char *persistent)
 {
     m_enabled = enabled;
+    m_offset  = offset;
+
+#   ifdef __linux__
+    persistentPath = persistent;
+#   else
+    (void) persistent;
+#   endif
+
+    if (enabled && gigantPages) {
+        m_flags |= GigantPages;
+    }
 }
 
 
 void Mem::allocate(MemInfo &info, bool enabled)
 {
     info.hugePages = 0;
+    info.tier      = MemInfo::Tier4K;
+
+#   ifdef __linux__
+    if (!persistentPath.isNull() && allocatePersistent(info)) {
+        return;
+    }
+#   endif
 
     if (!enabled) {
         info.memory = static_cast<uint8_t*>(malloc(info.size));
@@ -51,6 +214,12 @@ void Mem::allocate(MemInfo &info, bool enabled)
         return;
     }
 
+#   ifdef __linux__
+    if ((m_flags & GigantPages) && allocateGigant(info)) {
+        return;
+    }
+#   endif
+
 #   if defined(__APPLE__)
     info.memory = static_cast<uint8_t*>(mmap(0, info.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, VM_FLAGS_SUPERPAGE_SIZE_2MB, 0));
 #   elif defined(__FreeBSD__)
@@ -60,10 +229,20 @@ void Mem::allocate(MemInfo &info, bool enabled)
 #   endif
 
     if (info.memory == MAP_FAILED) {
-        return allocate(info, false);;
+#       ifdef __linux__
+        info.memory = allocateTHP(info.size);
+        if (info.memory) {
+            info.hugePages = anonHugePages(info.memory, info.size);
+            info.tier      = MemInfo::TierTHP;
+            return;
+        }
+#       endif
+
+        return allocate(info, false);
     }
 
     info.hugePages = info.pages;
+    info.tier      = MemInfo::Tier2M;
 
     if (madvise(info.memory, info.size, MADV_RANDOM | MADV_WILLNEED) != 0) {
         LOG_ERR("madvise failed");
@@ -77,26 +256,258 @@ void Mem::allocate(MemInfo &info, bool enabled)
 
 void Mem::release(MemInfo &info)
 {
-    if (info.hugePages) {
+#   ifdef __linux__
+    if (releasePersistent(info)) {
+        return;
+    }
+#   endif
+
+    switch (info.tier) {
+#   ifdef __linux__
+    case MemInfo::Tier1G:
+        releaseGigant(info);
+        break;
+#   endif
+
+    case MemInfo::Tier2M:
         if (m_flags & Lock) {
             munlock(info.memory, info.size);
         }
 
         munmap(info.memory, info.size);
-    }
-    else {
+        break;
+
+#   ifdef __linux__
+    case MemInfo::TierTHP:
+        munmap(info.memory, info.size + kGuardSize);
+        break;
+#   endif
+
+    default:
         free(info.memory);
+        break;
+    }
+}
+
+
+#ifdef __linux__
+bool Mem::allocateGigant(MemInfo &info)
+{
+    std::lock_guard<std::mutex> lock(poolsMutex);
+
+    const int node   = xmrig::Numa::currentNode();
+    GigantPool &pool = pools[node];
+
+    if (!pool.memory) {
+        const size_t size = (info.size + kGigantPageSize - 1) & ~(kGigantPageSize - 1);
+        uint8_t *memory   = static_cast<uint8_t*>(mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_HUGE_1GB | MAP_POPULATE, -1, 0));
+
+        if (memory == MAP_FAILED) {
+            pools.erase(node);
+            return false;
+        }
+
+        madvise(memory, size, MADV_RANDOM);
+        mlock(memory, size);
+
+        pool.memory = memory;
+        pool.size   = size;
+        pool.offset = 0;
     }
+
+    if (pool.offset + info.size > pool.size) {
+        return false;
+    }
+
+    info.memory    = pool.memory + pool.offset;
+    info.hugePages = info.pages;
+    info.tier      = MemInfo::Tier1G;
+
+    pool.offset += info.size;
+    pool.refs++;
+
+    return true;
+}
+
+
+/**
+ * Claims the first file of this size nobody else holds a lock on, creating it if needed. The lock goes away
+ * with the process, so after a restart or a crash the same files are found and mapped again.
+ */
+bool Mem::allocatePersistent(MemInfo &info)
+{
+    std::lock_guard<std::mutex> lock(poolsMutex);
+
+    for (size_t i = 0; i < kMaxPersistentFiles; ++i) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/xmrig-%zu-%zu", persistentPath.data(), info.size, i);
+
+        // The directory may be shared, never follow a planted symlink or truncate anything but a plain file.
+        const int fd = open(path, O_CREAT | O_RDWR | O_CLOEXEC | O_NOFOLLOW, 0600);
+        if (fd < 0) {
+            LOG_ERR("persistent scratchpad \"%s\" open failed: \"%s\"", path, strerror(errno));
+            return false;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+            LOG_ERR("persistent scratchpad \"%s\" is not a regular file", path);
+            close(fd);
+            return false;
+        }
+
+        if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+            close(fd);
+            continue;
+        }
+
+        struct statfs fs;
+        if (fstatfs(fd, &fs) != 0) {
+            close(fd);
+            return false;
+        }
+
+        const bool hugetlbfs = static_cast<long>(fs.f_type) == kHugetlbfsMagic;
+        const size_t page    = hugetlbfs ? static_cast<size_t>(fs.f_bsize) : 4096;
+        const size_t size    = (info.size + page - 1) & ~(page - 1);
+
+        if (static_cast<size_t>(st.st_size) < size && ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            close(fd);
+            return false;
+        }
+
+        uint8_t *memory = static_cast<uint8_t*>(mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0));
+        if (memory == MAP_FAILED) {
+            LOG_ERR("persistent scratchpad \"%s\" mmap failed: \"%s\"", path, strerror(errno));
+            close(fd);
+            return false;
+        }
+
+        PersistentFile &file = persistentFiles[memory];
+        file.fd   = fd;
+        file.size = size;
+
+        info.memory = memory;
+
+        if (hugetlbfs) {
+            info.hugePages = info.pages;
+            info.tier      = page >= kGigantPageSize ? MemInfo::Tier1G : MemInfo::Tier2M;
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+
+bool Mem::releasePersistent(MemInfo &info)
+{
+    std::lock_guard<std::mutex> lock(poolsMutex);
+
+    auto it = persistentFiles.find(info.memory);
+    if (it == persistentFiles.end()) {
+        return false;
+    }
+
+    munmap(info.memory, it->second.size);
+    close(it->second.fd);
+
+    persistentFiles.erase(it);
+
+    return true;
+}
+
+
+/**
+ * Files are named by scratchpad size, so after a change of threads, offset or algo-switch the old ones are
+ * never claimed again while their huge pages stay reserved. Every file in use is locked, by this or another
+ * running miner, so whatever can still be locked is stale and removed.
+ */
+void Mem::removeStalePersistent()
+{
+    std::lock_guard<std::mutex> lock(poolsMutex);
+
+    DIR *dir = opendir(persistentPath.data());
+    if (!dir) {
+        return;
+    }
+
+    size_t count = 0;
+    size_t size  = 0;
+
+    while (dirent *entry = readdir(dir)) {
+        size_t bytes = 0;
+        size_t index = 0;
+        char tail    = 0;
+
+        if (sscanf(entry->d_name, "xmrig-%zu-%zu%c", &bytes, &index, &tail) != 2) {
+            continue;
+        }
+
+        const int fd = openat(dirfd(dir), entry->d_name, O_RDWR | O_CLOEXEC | O_NOFOLLOW);
+        if (fd < 0) {
+            continue;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && flock(fd, LOCK_EX | LOCK_NB) == 0 && unlinkat(dirfd(dir), entry->d_name, 0) == 0) {
+            count++;
+            size += static_cast<size_t>(st.st_size);
+        }
+
+        close(fd);
+    }
+
+    closedir(dir);
+
+    if (count) {
+        LOG_WARN("removed %zu stale persistent scratchpad files (%zu MB) from \"%s\"", count, size / (1024 * 1024), persistentPath.data());
+    }
+}
+
+
+void Mem::releaseGigant(MemInfo &info)
+{
+    std::lock_guard<std::mutex> lock(poolsMutex);
+
+    for (auto it = pools.begin(); it != pools.end(); ++it) {
+        GigantPool &pool = it->second;
+
+        if (info.memory < pool.memory || info.memory >= pool.memory + pool.size) {
+            continue;
+        }
+
+        if (--pool.refs == 0) {
+            munmap(pool.memory, pool.size);
+            pools.erase(it);
+        }
+
+        return;
+    }
+}
+#endif
+
+
+void Mem::removeStaleFiles()
+{
+#   ifdef __linux__
+    if (!persistentPath.isNull()) {
+        removeStalePersistent();
+    }
+#   endif
 }
 
 
 void *Mem::allocateExecutableMemory(size_t size)
 {
 #   if defined(__APPLE__)
-    return mmap(0, size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANON, -1, 0);
+    void *mem = mmap(0, size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANON, -1, 0);
 #   else
-    return mmap(0, size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    void *mem = mmap(0, size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
 #   endif
+
+    return mem == MAP_FAILED ? nullptr : mem;
 }
 
 
@@ -106,6 +517,18 @@ void Mem::protectExecutableMemory(void *p, size_t size)
 }
 
 
+void Mem::unprotectExecutableMemory(void *p, size_t size)
+{
+    mprotect(p, size, PROT_READ | PROT_WRITE);
+}
+
+
+void Mem::releaseExecutableMemory(void *p, size_t size)
+{
+    munmap(p, size);
+}
+
+
 void Mem::flushInstructionCache(void *p, size_t size)
 {
 #   ifndef __FreeBSD__
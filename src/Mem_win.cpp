@@ -143,9 +143,10 @@ static BOOL TrySetLockPagesPrivilege() {
 }
 
 
-void Mem::init(bool enabled)
+void Mem::init(bool enabled, bool, size_t offset, const char *)
 {
     m_enabled = enabled;
+    m_offset  = offset;
 
     if (enabled && TrySetLockPagesPrivilege()) {
         m_flags |= HugepagesAvailable;
@@ -156,6 +157,7 @@ void Mem::init(bool enabled)
 void Mem::allocate(MemInfo &info, bool enabled)
 {
     info.hugePages = 0;
+    info.tier      = MemInfo::Tier4K;
 
     if (!enabled) {
         info.memory = static_cast<uint8_t*>(_mm_malloc(info.size, 4096));
@@ -166,6 +168,7 @@ void Mem::allocate(MemInfo &info, bool enabled)
     info.memory = static_cast<uint8_t*>(VirtualAlloc(nullptr, info.size, MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE));
     if (info.memory) {
         info.hugePages = info.pages;
+        info.tier      = MemInfo::Tier2M;
 
         return;
     }
@@ -176,7 +179,7 @@ void Mem::allocate(MemInfo &info, bool enabled)
 
 void Mem::release(MemInfo &info)
 {
-    if (info.hugePages) {
+    if (info.tier == MemInfo::Tier2M) {
         VirtualFree(info.memory, 0, MEM_RELEASE);
     }
     else {
@@ -185,6 +188,11 @@ void Mem::release(MemInfo &info)
 }
 
 
+void Mem::removeStaleFiles()
+{
+}
+
+
 void *Mem::allocateExecutableMemory(size_t size)
 {
     return VirtualAlloc(0, size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
@@ -198,6 +206,19 @@ void Mem::protectExecutableMemory(void *p, size_t size)
 }
 
 
+void Mem::unprotectExecutableMemory(void *p, size_t size)
+{
+    DWORD oldProtect;
+    VirtualProtect(p, size, PAGE_READWRITE, &oldProtect);
+}
+
+
+void Mem::releaseExecutableMemory(void *p, size_t size)
+{
+    VirtualFree(p, 0, MEM_RELEASE);
+}
+
+
 void Mem::flushInstructionCache(void *p, size_t size)
 {
     ::FlushInstructionCache(GetCurrentProcess(), p, size);
@@ -337,6 +337,18 @@ void xmrig::Pool::setAlgo(const xmrig::Algorithm &algorithm)
 }
 
 
+/**
+ * Additional algorithm families the miner can switch to without a restart, they are offered to the pool
+ * in login and jobs for them are accepted.
+ */
+void xmrig::Pool::setSwitchAlgorithms(const std::vector<Algo> &algorithms)
+{
+    m_switch = algorithms;
+
+    rebuild();
+}
+
+
 #ifdef APP_DEBUG
 void xmrig::Pool::print() const
 {
@@ -376,9 +388,9 @@ bool xmrig::Pool::parseIPv6(const char *addr)
 }
 
 
-void xmrig::Pool::addVariant(xmrig::Variant variant)
+void xmrig::Pool::addVariant(xmrig::Algo algo, xmrig::Variant variant)
 {
-    const xmrig::Algorithm algorithm(m_algorithm.algo(), variant);
+    const xmrig::Algorithm algorithm(algo, variant);
     if (!algorithm.isValid() || m_algorithm == algorithm) {
         return;
     }
@@ -387,6 +399,28 @@ void xmrig::Pool::addVariant(xmrig::Variant variant)
 }
 
 
+void xmrig::Pool::addVariants(xmrig::Algo algo)
+{
+    addVariant(algo, VARIANT_4);
+    addVariant(algo, VARIANT_WOW);
+    addVariant(algo, VARIANT_2);
+    addVariant(algo, VARIANT_1);
+    addVariant(algo, VARIANT_0);
+    addVariant(algo, VARIANT_HALF);
+    addVariant(algo, VARIANT_XTL);
+    addVariant(algo, VARIANT_TUBE);
+    addVariant(algo, VARIANT_MSR);
+    addVariant(algo, VARIANT_XHV);
+    addVariant(algo, VARIANT_XAO);
+    addVariant(algo, VARIANT_RTO);
+    addVariant(algo, VARIANT_GPU);
+    addVariant(algo, VARIANT_RWZ);
+    addVariant(algo, VARIANT_ZLS);
+    addVariant(algo, VARIANT_DOUBLE);
+    addVariant(algo, VARIANT_AUTO);
+}
+
+
 void xmrig::Pool::adjustVariant(const xmrig::Variant variantHint)
 {
 #   ifndef XMRIG_PROXY_PROJECT
@@ -484,22 +518,12 @@ void xmrig::Pool::rebuild()
     m_algorithms.push_back(m_algorithm);
 
 #   ifndef XMRIG_PROXY_PROJECT
-    addVariant(VARIANT_4);
-    addVariant(VARIANT_WOW);
-    addVariant(VARIANT_2);
-    addVariant(VARIANT_1);
-    addVariant(VARIANT_0);
-    addVariant(VARIANT_HALF);
-    addVariant(VARIANT_XTL);
-    addVariant(VARIANT_TUBE);
-    addVariant(VARIANT_MSR);
-    addVariant(VARIANT_XHV);
-    addVariant(VARIANT_XAO);
-    addVariant(VARIANT_RTO);
-    addVariant(VARIANT_GPU);
-    addVariant(VARIANT_RWZ);
-    addVariant(VARIANT_ZLS);
-    addVariant(VARIANT_DOUBLE);
-    addVariant(VARIANT_AUTO);
+    addVariants(m_algorithm.algo());
+
+    for (Algo algo : m_switch) {
+        if (algo != m_algorithm.algo()) {
+            addVariants(algo);
+        }
+    }
 #   endif
 }
@@ -91,6 +91,7 @@ public:
     rapidjson::Value toJSON(rapidjson::Document &doc) const;
     void adjust(const Algorithm &algorithm);
     void setAlgo(const Algorithm &algorithm);
+    void setSwitchAlgorithms(const std::vector<Algo> &algorithms);
 
 #   ifdef APP_DEBUG
     void print() const;
@@ -98,7 +99,8 @@ public:
 
 private:
     bool parseIPv6(const char *addr);
-    void addVariant(Variant variant);
+    void addVariant(Algo algo, Variant variant);
+    void addVariants(Algo algo);
     void adjustVariant(const Variant variantHint);
     void rebuild();
 
@@ -115,6 +117,7 @@ private:
     String m_url;
     String m_user;
     uint16_t m_port;
+    std::vector<Algo> m_switch;
 };
 
 
@@ -137,6 +137,14 @@ void xmrig::Pools::adjust(const Algorithm &algorithm)
 }
 
 
+void xmrig::Pools::setSwitchAlgorithms(const std::vector<Algo> &algorithms)
+{
+    for (Pool &pool : m_data) {
+        pool.setSwitchAlgorithms(algorithms);
+    }
+}
+
+
 void xmrig::Pools::load(const rapidjson::Value &pools)
 {
     m_data.clear();
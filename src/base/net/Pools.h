@@ -68,6 +68,7 @@ public:
     rapidjson::Value toJSON(rapidjson::Document &doc) const;
     size_t active() const;
     void adjust(const Algorithm &algorithm);
+    void setSwitchAlgorithms(const std::vector<Algo> &algorithms);
     void load(const rapidjson::Value &pools);
     void print() const;
     void setRetries(int retries);
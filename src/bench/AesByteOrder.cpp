@@ -0,0 +1,261 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2016-2018 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Compares the two byte orders of the POWER hardware AES in the scratchpad explode and implode loops: x86 order,
+ * where every vcipher is wrapped in byte swaps of the state, the key and the result (_mm_aesenc_si128), and
+ * vcipher-native order, where the data is swapped once when it enters or leaves memory, as cn_explode_scratchpad
+ * and cn_implode_scratchpad in CryptoNight_ppc64.h do. Both loops must leave the same bytes in memory. The hash
+ * rate of the single way kernel is printed for scale on every platform.
+ *
+ * usage: xmrig-bench-aes [algo] [iterations]
+ */
+
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#include "common/cpu/Cpu.h"
+#include "common/cpu/Numa.h"
+#include "common/crypto/Algorithm.h"
+#include "common/crypto/keccak.h"
+#include "crypto/CryptoNight.h"
+#include "crypto/CryptoNight_constants.h"
+#include "crypto/CryptoNight_test.h"
+#include "Mem.h"
+#include "workers/CpuThread.h"
+
+
+#ifdef XMRIG_PPC64
+#include "crypto/soft_aes.h"
+
+
+template<bool NATIVE>
+static inline __m128i load(const __m128i *p)
+{
+    return NATIVE ? v_rev(_mm_load_si128(p)) : _mm_load_si128(p);
+}
+
+
+template<bool NATIVE>
+static inline void store(__m128i *p, __m128i x)
+{
+    _mm_store_si128(p, NATIVE ? v_rev(x) : x);
+}
+
+
+template<bool NATIVE>
+static inline void rounds(const __m128i *keys, __m128i *x)
+{
+    for (size_t k = 0; k < 10; ++k) {
+        for (size_t j = 0; j < 8; ++j) {
+            x[j] = NATIVE ? v_aesenc_be(x[j], keys[k]) : _mm_aesenc_si128(x[j], keys[k]);
+        }
+    }
+}
+
+
+// Same shape as cn_explode_scratchpad, without the cn-heavy mixing.
+template<bool NATIVE>
+static void explode(const __m128i *keys, const __m128i *state, __m128i *memory, size_t size)
+{
+    __m128i x[8];
+    for (size_t j = 0; j < 8; ++j) {
+        x[j] = load<NATIVE>(state + 4 + j);
+    }
+
+    for (size_t i = 0; i < size / sizeof(__m128i); i += 8) {
+        rounds<NATIVE>(keys, x);
+
+        for (size_t j = 0; j < 8; ++j) {
+            store<NATIVE>(memory + i + j, x[j]);
+        }
+    }
+}
+
+
+// Same shape as cn_implode_scratchpad, without the cn-heavy mixing.
+template<bool NATIVE>
+static void implode(const __m128i *keys, const __m128i *memory, __m128i *state, size_t size)
+{
+    __m128i x[8];
+    for (size_t j = 0; j < 8; ++j) {
+        x[j] = load<NATIVE>(state + 4 + j);
+    }
+
+    for (size_t i = 0; i < size / sizeof(__m128i); i += 8) {
+        for (size_t j = 0; j < 8; ++j) {
+            x[j] = vec_xor(load<NATIVE>(memory + i + j), x[j]);
+        }
+
+        rounds<NATIVE>(keys, x);
+    }
+
+    for (size_t j = 0; j < 8; ++j) {
+        store<NATIVE>(state + 4 + j, x[j]);
+    }
+}
+
+
+struct Result
+{
+    double explode;
+    double implode;
+};
+
+
+template<bool NATIVE>
+static Result measure(const __m128i *keys, const __m128i *state, __m128i *memory, size_t size, uint64_t iterations, __m128i *out)
+{
+    using namespace std::chrono;
+
+    // The keys stay in a register for the whole loop, so their byte order is fixed once up front in both modes.
+    __m128i k[10];
+    for (size_t i = 0; i < 10; ++i) {
+        k[i] = NATIVE ? v_rev(keys[i]) : keys[i];
+    }
+
+    Result result = { 0.0, 0.0 };
+
+    for (uint64_t i = 0; i < iterations; ++i) {
+        memcpy(out, state, 200);
+
+        auto start = steady_clock::now();
+        explode<NATIVE>(k, out, memory, size);
+        result.explode += duration<double, std::micro>(steady_clock::now() - start).count();
+
+        start = steady_clock::now();
+        implode<NATIVE>(k, memory, out, size);
+        result.implode += duration<double, std::micro>(steady_clock::now() - start).count();
+    }
+
+    result.explode /= iterations;
+    result.implode /= iterations;
+
+    return result;
+}
+
+
+static void print(const char *name, const Result &result, size_t size)
+{
+    printf("  %-8s explode %10.1f us %8.2f GB/s   implode %10.1f us %8.2f GB/s\n",
+           name,
+           result.explode, size / result.explode / 1e3,
+           result.implode, size / result.implode / 1e3);
+}
+#endif
+
+
+static double hashrate(xmrig::Algo algorithm, xmrig::CpuThread::cn_hash_fun fn, uint64_t iterations)
+{
+    using namespace std::chrono;
+
+    cryptonight_ctx *ctx[1] = { nullptr };
+    uint8_t output[32];
+
+    MemInfo info = Mem::create(ctx, algorithm, 1);
+    fn(test_input, 76, output, ctx, 0);
+
+    const auto start = steady_clock::now();
+    for (uint64_t i = 0; i < iterations; ++i) {
+        fn(test_input, 76, output, ctx, 0);
+    }
+
+    const double elapsed = duration<double>(steady_clock::now() - start).count();
+
+    Mem::release(ctx, 1, info);
+
+    return iterations / elapsed;
+}
+
+
+int main(int argc, char **argv)
+{
+    using namespace xmrig;
+
+    const Algorithm algorithm(argc > 1 ? argv[1] : "cn/2");
+    const uint64_t iterations = argc > 2 ? strtoull(argv[2], nullptr, 10) : 64;
+
+    if (!algorithm.isValid() || iterations == 0) {
+        fprintf(stderr, "usage: %s [algo] [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    Cpu::init();
+    Numa::init();
+
+#   ifndef XMRIG_NO_ASM
+    CpuThread::patchAsmVariants();
+#   endif
+
+    Mem::init(true);
+
+    const size_t size = cn_select_memory(algorithm.algo());
+    printf("%s, %zu KB scratchpad, %llu iterations\n", algorithm.name(), size / 1024, static_cast<unsigned long long>(iterations));
+
+#   ifdef XMRIG_PPC64
+    if (Cpu::info()->hasAES()) {
+        alignas(16) uint8_t state[208];
+        xmrig::keccak(test_input, 76, state);
+
+        cryptonight_ctx *ctx[2] = { nullptr, nullptr };
+        MemInfo info = Mem::create(ctx, algorithm.algo(), 2);
+
+        __m128i *memory     = reinterpret_cast<__m128i *>(ctx[0]->memory);
+        __m128i *swapped    = reinterpret_cast<__m128i *>(ctx[1]->memory);
+        const __m128i *keys = reinterpret_cast<const __m128i *>(state);
+
+        alignas(16) uint8_t nativeState[208];
+        alignas(16) uint8_t swappedState[208];
+
+        // Warm up the scratchpad pages before the first row.
+        measure<true>(keys, reinterpret_cast<const __m128i *>(state), memory, size, 1, reinterpret_cast<__m128i *>(nativeState));
+
+        print("x86", measure<false>(keys, reinterpret_cast<const __m128i *>(state), swapped, size, iterations, reinterpret_cast<__m128i *>(swappedState)), size);
+        print("native", measure<true>(keys, reinterpret_cast<const __m128i *>(state), memory, size, iterations, reinterpret_cast<__m128i *>(nativeState)), size);
+
+        if (memcmp(memory, swapped, size) != 0 || memcmp(nativeState, swappedState, 200) != 0) {
+            printf("  the two byte orders produce different data\n");
+        }
+
+        Mem::release(ctx, 2, info);
+    }
+    else {
+        printf("  no hardware AES, the byte order comparison needs vcipher\n");
+    }
+#   else
+    printf("  the byte order comparison needs POWER vcipher\n");
+#   endif
+
+    CpuThread::cn_hash_fun fn = CpuThread::fn(algorithm.algo(), Cpu::info()->hasAES() ? AV_SINGLE : AV_SINGLE_SOFT, algorithm.variant(), ASM_AUTO);
+    if (fn) {
+        printf("  kernel   %10.2f H/s\n", hashrate(algorithm.algo(), fn, iterations));
+    }
+
+    Cpu::release();
+
+    return 0;
+}
@@ -0,0 +1,306 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2016-2018 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Compares the CryptoNight-R random math run by the JIT with the portable interpreter, per program over a range
+ * of block heights: the interpreter cost of one run, and on POWER the JIT compile cost, the cost of one run of the
+ * compiled fragment and how many runs pay back the compile. Where the tree has the x86 code generator the whole
+ * cn/r hash is compared as well, generated main loop against the C kernel. Last it checks that the code cache still
+ * holds the previous height for a late job once the next height has been compiled ahead of time.
+ *
+ * usage: xmrig-bench-cnr [heights] [runs per height]
+ */
+
+
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+
+#include "common/cpu/Cpu.h"
+#include "common/cpu/Numa.h"
+#include "common/crypto/Algorithm.h"
+#include "crypto/CnRCache.h"
+#include "crypto/CryptoNight.h"
+#include "crypto/CryptoNight_monero.h"
+#include "crypto/CryptoNight_test.h"
+#include "Mem.h"
+#include "workers/CpuThread.h"
+
+
+static const uint64_t firstHeight = 1806260;
+static std::atomic<uint32_t> minedCompiles(0);
+static std::atomic<uint32_t> otherCompiles(0);
+
+
+static inline void initRegisters(uint32_t *r, uint64_t height)
+{
+    for (uint32_t i = 0; i < 9; ++i) {
+        r[i] = static_cast<uint32_t>(height * 0x9E3779B97F4A7C15ULL >> (i * 3)) | 1;
+    }
+}
+
+
+static inline uint32_t checksum(const uint32_t *r)
+{
+    return r[0] ^ r[1] ^ r[2] ^ r[3];
+}
+
+
+static double interpreter(uint64_t heights, uint64_t runs, uint32_t *sums)
+{
+    using namespace std::chrono;
+
+    V4_Instruction code[256];
+    double ns = 0.0;
+
+    for (uint64_t i = 0; i < heights; ++i) {
+        v4_random_math_init<xmrig::VARIANT_4>(code, firstHeight + i);
+
+        uint32_t r[9];
+        initRegisters(r, firstHeight + i);
+
+        const auto start = steady_clock::now();
+        for (uint64_t j = 0; j < runs; ++j) {
+            v4_random_math(code, r);
+        }
+
+        ns += duration<double, std::nano>(steady_clock::now() - start).count();
+        sums[i] = checksum(r);
+    }
+
+    return ns / (heights * runs);
+}
+
+
+#ifdef XMRIG_PPC64
+struct JitResult
+{
+    double compile;
+    double run;
+    uint64_t mismatches;
+};
+
+
+static JitResult jit(uint64_t heights, uint64_t runs, const uint32_t *sums)
+{
+    using namespace std::chrono;
+
+    const size_t size = INST_LEN * sizeof(uint32_t);
+    void *machine_code = Mem::allocateExecutableMemory(size);
+
+    V4_Instruction code[256];
+    JitResult result = { 0.0, 0.0, 0 };
+
+    for (uint64_t i = 0; i < heights; ++i) {
+        v4_random_math_init<xmrig::VARIANT_4>(code, firstHeight + i);
+
+        Mem::unprotectExecutableMemory(machine_code, size);
+
+        auto start = steady_clock::now();
+        JIT_compile_v3(code, machine_code, INST_LEN);
+        result.compile += duration<double, std::nano>(steady_clock::now() - start).count();
+
+        Mem::protectExecutableMemory(machine_code, size);
+        Mem::flushInstructionCache(machine_code, size);
+
+        const fn1 fn = reinterpret_cast<fn1>(machine_code);
+
+        uint32_t r[9];
+        initRegisters(r, firstHeight + i);
+
+        start = steady_clock::now();
+        for (uint64_t j = 0; j < runs; ++j) {
+            fn(r);
+        }
+
+        result.run += duration<double, std::nano>(steady_clock::now() - start).count();
+
+        if (checksum(r) != sums[i]) {
+            result.mismatches++;
+        }
+    }
+
+    Mem::unprotectExecutableMemory(machine_code, size);
+
+    result.compile /= heights;
+    result.run     /= heights * runs;
+
+    return result;
+}
+#endif
+
+
+// Stand-in compilers for the cache check, the emitted code is never run. Two functions put the two streams of
+// heights into different cache classes.
+static size_t compileMined(const V4_Instruction *, int, void *machine_code, xmrig::Assembly)
+{
+    *static_cast<uint8_t *>(machine_code) = 0;
+    minedCompiles++;
+
+    return 1;
+}
+
+
+static size_t compileOther(const V4_Instruction *, int, void *machine_code, xmrig::Assembly)
+{
+    *static_cast<uint8_t *>(machine_code) = 0;
+    otherCompiles++;
+
+    return 1;
+}
+
+
+// Heights ahead are compiled by the cache thread, wait until it has caught up.
+static void settle(const std::atomic<uint32_t> &compiles, uint32_t expected)
+{
+    for (int i = 0; i < 1000 && compiles < expected; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+
+static bool lateJob()
+{
+    using namespace xmrig;
+
+    const size_t heights = CnRCache::kSlots * 2;
+
+    // Mining moved from height - 1 to height, height + 1 is compiled ahead of time.
+    CnRCache::release(CnRCache::get(VARIANT_4, firstHeight - 1, ASM_NONE, 1, compileMined));
+    CnRCache::release(CnRCache::get(VARIANT_4, firstHeight, ASM_NONE, 1, compileMined));
+    settle(minedCompiles, 3);
+
+    // Another class walks through more heights than the cache has slots.
+    for (size_t i = 0; i < heights; ++i) {
+        CnRCache::release(CnRCache::get(VARIANT_4, firstHeight + 1000 + i, ASM_NONE, 1, compileOther));
+    }
+
+    settle(otherCompiles, heights + 1);
+
+    const uint32_t compiles = minedCompiles;
+    CnRCache::release(CnRCache::get(VARIANT_4, firstHeight - 1, ASM_NONE, 1, compileMined));
+
+    return minedCompiles == compiles;
+}
+
+
+#ifndef XMRIG_NO_ASM
+static double hashrate(xmrig::CpuThread::cn_hash_fun fn, uint64_t heights, uint64_t runs)
+{
+    using namespace std::chrono;
+
+    cryptonight_ctx *ctx[1] = { nullptr };
+    uint8_t output[32];
+
+    MemInfo info = Mem::create(ctx, xmrig::CRYPTONIGHT, 1);
+    fn(test_input, 76, output, ctx, firstHeight);
+
+    // A new height every few hashes, so the generated kernel also pays for its code generation.
+    const auto start = steady_clock::now();
+    for (uint64_t i = 0; i < heights; ++i) {
+        for (uint64_t j = 0; j < runs; ++j) {
+            fn(test_input, 76, output, ctx, firstHeight + i);
+        }
+    }
+
+    const double elapsed = duration<double>(steady_clock::now() - start).count();
+
+    Mem::release(ctx, 1, info);
+
+    return heights * runs / elapsed;
+}
+#endif
+
+
+int main(int argc, char **argv)
+{
+    using namespace xmrig;
+
+    const uint64_t heights = argc > 1 ? strtoull(argv[1], nullptr, 10) : 256;
+    const uint64_t runs    = argc > 2 ? strtoull(argv[2], nullptr, 10) : 4096;
+
+    if (heights == 0 || runs == 0) {
+        fprintf(stderr, "usage: %s [heights] [runs per height]\n", argv[0]);
+        return 1;
+    }
+
+    Cpu::init();
+    Numa::init();
+
+#   ifndef XMRIG_NO_ASM
+    CpuThread::patchAsmVariants();
+#   endif
+
+    Mem::init(true);
+
+    printf("cn/r random math, %llu heights, %llu runs per height\n", static_cast<unsigned long long>(heights), static_cast<unsigned long long>(runs));
+
+    uint32_t *sums = new uint32_t[heights];
+
+    const double interpreted = interpreter(heights, runs, sums);
+    printf("  interpreter  %10.1f ns/run\n", interpreted);
+
+#   ifdef XMRIG_PPC64
+    const JitResult compiled = jit(heights, runs, sums);
+    printf("  jit          %10.1f ns/run  %10.0f ns/compile", compiled.run, compiled.compile);
+
+    if (compiled.run < interpreted) {
+        printf("  break-even %.0f runs", compiled.compile / (interpreted - compiled.run));
+    }
+
+    printf("\n");
+
+    if (compiled.mismatches) {
+        printf("  jit and interpreter disagree on %llu of %llu programs\n", static_cast<unsigned long long>(compiled.mismatches), static_cast<unsigned long long>(heights));
+    }
+#   else
+    printf("  jit          not available on this platform\n");
+#   endif
+
+    delete [] sums;
+
+#   ifndef XMRIG_NO_ASM
+    const AlgoVariant av = Cpu::info()->hasAES() ? AV_SINGLE : AV_SINGLE_SOFT;
+    CpuThread::cn_hash_fun generated = CpuThread::fn(CRYPTONIGHT, av, VARIANT_4, ASM_AUTO);
+    CpuThread::cn_hash_fun portable  = CpuThread::fn(CRYPTONIGHT, av, VARIANT_4, ASM_NONE);
+
+    if (generated && portable && generated != portable) {
+        const uint64_t hashes = runs / 256 ? runs / 256 : 1;
+
+        printf("cn/r hash, %llu heights, %llu hashes per height\n", static_cast<unsigned long long>(heights), static_cast<unsigned long long>(hashes));
+        printf("  interpreter  %10.2f H/s\n", hashrate(portable, heights, hashes));
+        printf("  generated    %10.2f H/s\n", hashrate(generated, heights, hashes));
+    }
+#   endif
+
+    const bool hit = lateJob();
+    printf("cn/r code cache\n  late job for the previous height %s\n", hit ? "hit" : "missed, it was recompiled");
+
+    Cpu::release();
+
+    return hit ? 0 : 1;
+}
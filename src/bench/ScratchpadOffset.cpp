@@ -0,0 +1,172 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2016-2018 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+/**
+ * Sweeps --scratchpad-offset for one algorithm and multiway width and prints the hashrate of each step, to
+ * pick the best scratchpad layout for a CPU model.
+ *
+ * usage: xmrig-bench-offset [algo] [ways] [seconds] [max offset] [step]
+ */
+
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#include "common/cpu/Cpu.h"
+#include "common/cpu/Numa.h"
+#include "common/crypto/Algorithm.h"
+#include "crypto/CryptoNight.h"
+#include "crypto/CryptoNight_test.h"
+#include "Mem.h"
+#include "workers/CpuThread.h"
+
+
+static xmrig::AlgoVariant algoVariant(size_t ways, bool softAES)
+{
+    using namespace xmrig;
+
+    switch (ways) {
+    case 1:
+        return softAES ? AV_SINGLE_SOFT : AV_SINGLE;
+
+    case 2:
+        return softAES ? AV_DOUBLE_SOFT : AV_DOUBLE;
+
+    case 3:
+        return softAES ? AV_TRIPLE_SOFT : AV_TRIPLE;
+
+    case 4:
+        return softAES ? AV_QUAD_SOFT : AV_QUAD;
+
+    case 5:
+        return softAES ? AV_PENTA_SOFT : AV_PENTA;
+
+    case 8:
+        return softAES ? AV_OCTA_SOFT : AV_OCTA;
+
+    case 16:
+        return softAES ? AV_HEXADECA_SOFT : AV_HEXADECA;
+
+    default:
+        break;
+    }
+
+    return AV_AUTO;
+}
+
+
+static double measure(const xmrig::Algorithm &algorithm, xmrig::CpuThread::cn_hash_fun fn, size_t ways, size_t offset, double seconds)
+{
+    using namespace std::chrono;
+
+    cryptonight_ctx *ctx[16] = { nullptr };
+    uint8_t input[76 * 16];
+    uint8_t output[32 * 16];
+
+    for (size_t i = 0; i < ways; ++i) {
+        memcpy(input + i * 76, test_input + (i % (sizeof(test_input) / 76)) * 76, 76);
+    }
+
+    Mem::init(true, false, offset);
+    MemInfo info = Mem::create(ctx, algorithm.algo(), ways);
+
+    fn(input, 76, output, ctx, 0);
+
+    size_t hashes    = 0;
+    const auto start = steady_clock::now();
+    double elapsed   = 0.0;
+
+    do {
+        fn(input, 76, output, ctx, 0);
+        hashes += ways;
+
+        elapsed = duration<double>(steady_clock::now() - start).count();
+    } while (elapsed < seconds);
+
+    Mem::release(ctx, ways, info);
+
+    return hashes / elapsed;
+}
+
+
+int main(int argc, char **argv)
+{
+    using namespace xmrig;
+
+    const Algorithm algorithm(argc > 1 ? argv[1] : "cn/2");
+    const size_t ways      = argc > 2 ? strtoul(argv[2], nullptr, 10) : 2;
+    const double seconds   = argc > 3 ? strtod(argv[3], nullptr) : 5.0;
+    const size_t maxOffset = argc > 4 ? strtoul(argv[4], nullptr, 10) : 4096;
+    const size_t step      = argc > 5 ? strtoul(argv[5], nullptr, 10) : 64;
+
+    if (!algorithm.isValid() || step < 64 || step % 64 != 0) {
+        fprintf(stderr, "usage: %s [algo] [ways] [seconds] [max offset] [step, multiple of 64]\n", argv[0]);
+        return 1;
+    }
+
+    Cpu::init();
+    Numa::init();
+
+#   ifndef XMRIG_NO_ASM
+    CpuThread::patchAsmVariants();
+#   endif
+
+    const AlgoVariant av = algoVariant(ways, !Cpu::info()->hasAES());
+    if (av == AV_AUTO || ways > CpuThread::maxMultiway(algorithm.algo())) {
+        fprintf(stderr, "%zu-way hashing is not supported for %s\n", ways, algorithm.name());
+        return 1;
+    }
+
+    CpuThread::cn_hash_fun fn = CpuThread::fn(algorithm.algo(), av, algorithm.variant(), ASM_AUTO);
+    if (!fn) {
+        fprintf(stderr, "no implementation for %s av=%d\n", algorithm.name(), static_cast<int>(av));
+        return 1;
+    }
+
+    printf("%s, %zu-way, %.1f s per step\n", algorithm.name(), ways, seconds);
+
+    size_t best       = 0;
+    double bestResult = 0.0;
+
+    for (size_t offset = 0; offset <= maxOffset; offset += step) {
+        const double hashrate = measure(algorithm, fn, ways, offset, seconds);
+        if (hashrate > bestResult) {
+            best       = offset;
+            bestResult = hashrate;
+        }
+
+        printf("offset %7zu  %10.2f H/s\n", offset, hashrate);
+        fflush(stdout);
+    }
+
+    printf("best offset %zu (%.2f H/s)\n", best, bestResult);
+
+    Cpu::release();
+
+    return 0;
+}
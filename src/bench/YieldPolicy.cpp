@@ -0,0 +1,197 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2016-2018 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Measures the per-hash cost of the worker yield policies (--yield-interval), first with the hashing thread alone
+ * on its CPU and then sharing it with busy threads, as on a host running other work. The --yield-load policy
+ * switches between "never" and the configured interval, so its cost is one of the rows.
+ *
+ * usage: xmrig-bench-yield [algo] [seconds] [busy threads]
+ */
+
+
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+
+#include "common/cpu/Cpu.h"
+#include "common/cpu/Numa.h"
+#include "common/crypto/Algorithm.h"
+#include "common/Platform.h"
+#include "crypto/CryptoNight.h"
+#include "crypto/CryptoNight_test.h"
+#include "Mem.h"
+#include "workers/CpuThread.h"
+
+
+static const uint32_t intervals[] = { 0, 1, 16, 256 };
+
+
+struct Result
+{
+    double hashrate;
+    double busy;
+};
+
+
+static Result measure(xmrig::Algo algorithm, xmrig::CpuThread::cn_hash_fun fn, uint32_t interval, size_t busyThreads, double seconds)
+{
+    using namespace std::chrono;
+
+    cryptonight_ctx *ctx[1] = { nullptr };
+    uint8_t output[32];
+
+    MemInfo info = Mem::create(ctx, algorithm, 1);
+    fn(test_input, 76, output, ctx, 0);
+
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> spins(0);
+    std::vector<std::thread> busy;
+
+    for (size_t i = 0; i < busyThreads; ++i) {
+        busy.emplace_back([&stop, &spins]() {
+            Platform::setThreadAffinity(0);
+
+            uint64_t count = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                ++count;
+            }
+
+            spins += count;
+        });
+    }
+
+    // Same shape as the MultiWorker hash loop.
+    size_t hashes    = 0;
+    uint32_t rounds  = 0;
+    const auto start = steady_clock::now();
+    double elapsed   = 0.0;
+
+    do {
+        fn(test_input, 76, output, ctx, 0);
+        hashes++;
+
+        if (interval && ++rounds >= interval) {
+            rounds = 0;
+            std::this_thread::yield();
+        }
+
+        elapsed = duration<double>(steady_clock::now() - start).count();
+    } while (elapsed < seconds);
+
+    stop = true;
+    for (std::thread &thread : busy) {
+        thread.join();
+    }
+
+    Mem::release(ctx, 1, info);
+
+    Result result;
+    result.hashrate = hashes / elapsed;
+    result.busy     = spins / elapsed / 1e6;
+
+    return result;
+}
+
+
+static void run(xmrig::Algo algorithm, xmrig::CpuThread::cn_hash_fun fn, size_t busyThreads, double seconds)
+{
+    printf("%s\n", busyThreads ? "shared CPU" : "dedicated CPU");
+
+    double base = 0.0;
+
+    for (uint32_t interval : intervals) {
+        const Result result = measure(algorithm, fn, interval, busyThreads, seconds);
+        if (interval == 0) {
+            base = result.hashrate;
+        }
+
+        const double overhead = (1e9 / result.hashrate) - (1e9 / base);
+
+        if (interval == 0) {
+            printf("  never       %10.2f H/s  %+10.0f ns/hash", result.hashrate, overhead);
+        }
+        else {
+            printf("  every %-5u %10.2f H/s  %+10.0f ns/hash", interval, result.hashrate, overhead);
+        }
+
+        if (busyThreads) {
+            printf("  busy threads %8.1f M spins/s", result.busy);
+        }
+
+        printf("\n");
+        fflush(stdout);
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    using namespace xmrig;
+
+    const Algorithm algorithm(argc > 1 ? argv[1] : "cn-pico/trtl");
+    const double seconds     = argc > 2 ? strtod(argv[2], nullptr) : 3.0;
+    const size_t busyThreads = argc > 3 ? strtoul(argv[3], nullptr, 10) : 1;
+
+    if (!algorithm.isValid() || seconds <= 0.0) {
+        fprintf(stderr, "usage: %s [algo] [seconds] [busy threads]\n", argv[0]);
+        return 1;
+    }
+
+    Cpu::init();
+    Numa::init();
+
+#   ifndef XMRIG_NO_ASM
+    CpuThread::patchAsmVariants();
+#   endif
+
+    CpuThread::cn_hash_fun fn = CpuThread::fn(algorithm.algo(), Cpu::info()->hasAES() ? AV_SINGLE : AV_SINGLE_SOFT, algorithm.variant(), ASM_AUTO);
+    if (!fn) {
+        fprintf(stderr, "no implementation for %s\n", algorithm.name());
+        return 1;
+    }
+
+    // Everything runs on CPU 0, so the busy threads compete with the hashing thread.
+    Platform::setThreadAffinity(0);
+    Mem::init(true);
+
+    printf("%s, %.1f s per policy\n", algorithm.name(), seconds);
+
+    // Warm up caches, page tables and the CPU clock before the first row.
+    measure(algorithm.algo(), fn, 0, 0, seconds);
+
+    run(algorithm.algo(), fn, 0, seconds);
+
+    if (busyThreads) {
+        run(algorithm.algo(), fn, busyThreads, seconds);
+    }
+
+    Cpu::release();
+
+    return 0;
+}
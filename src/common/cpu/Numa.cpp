@@ -0,0 +1,264 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2016-2018 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+
+#ifdef __linux__
+#   include <dirent.h>
+#   include <sched.h>
+#   include <sys/syscall.h>
+#   include <unistd.h>
+#endif
+
+
+#include "common/cpu/Numa.h"
+
+
+size_t xmrig::Numa::m_nodes = 1;
+
+
+#ifdef __linux__
+namespace {
+
+// From <numaif.h>, declared here to avoid a hard dependency on libnuma.
+static constexpr const int kMpolPreferred = 1;
+static constexpr const int kMpolFNode     = 1 << 0;
+static constexpr const int kMpolFAddr     = 1 << 1;
+static constexpr const size_t kMaxNodes   = 1024;
+
+
+static std::vector<int> cpuNodes;
+static std::vector<int> cpuToNode;
+static std::vector<std::vector<int> > nodeCpus;
+
+
+static void parseCpuList(const char *list, int node)
+{
+    const char *p = list;
+
+    while (*p) {
+        char *end     = nullptr;
+        const long lo = strtol(p, &end, 10);
+        long hi       = lo;
+
+        if (end == p) {
+            break;
+        }
+
+        if (*end == '-') {
+            p  = end + 1;
+            hi = strtol(p, &end, 10);
+        }
+
+        for (long cpu = lo; cpu <= hi && cpu >= 0; ++cpu) {
+            if (static_cast<size_t>(cpu) >= cpuToNode.size()) {
+                cpuToNode.resize(cpu + 1, -1);
+            }
+
+            cpuToNode[cpu] = node;
+            nodeCpus[node].push_back(static_cast<int>(cpu));
+        }
+
+        p = *end == ',' ? end + 1 : end;
+    }
+}
+
+} // namespace
+#endif
+
+
+/**
+ * Prefer the given node for every page the calling thread faults in from now on, including MAP_POPULATE
+ * and hugetlb mappings, so scratchpads end up local without having to mbind each allocation.
+ */
+bool xmrig::Numa::bindMemory(int node)
+{
+#   if defined(__linux__) && defined(SYS_set_mempolicy)
+    if (m_nodes < 2 || node < 0 || static_cast<size_t>(node) >= kMaxNodes) {
+        return false;
+    }
+
+    unsigned long mask[kMaxNodes / (8 * sizeof(unsigned long))] = { 0 };
+    mask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+
+    return syscall(SYS_set_mempolicy, kMpolPreferred, mask, kMaxNodes) == 0;
+#   else
+    return false;
+#   endif
+}
+
+
+/**
+ * Restrict the calling thread to the CPUs of the node and bind its memory there, used for threads without
+ * explicit affinity so the scheduler can't move them away from their scratchpad. Only CPUs of the inherited
+ * mask (taskset, cgroup cpuset, systemd CPUAffinity) are used, if none of them is on the node nothing changes.
+ */
+bool xmrig::Numa::bindThread(int node)
+{
+#   ifdef __linux__
+    if (m_nodes < 2 || node < 0 || static_cast<size_t>(node) >= nodeCpus.size() || nodeCpus[node].empty()) {
+        return false;
+    }
+
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return false;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+
+    for (int cpu : nodeCpus[node]) {
+        if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed)) {
+            CPU_SET(cpu, &set);
+        }
+    }
+
+    if (CPU_COUNT(&set) == 0 || sched_setaffinity(0, sizeof(set), &set) != 0) {
+        return false;
+    }
+
+    return bindMemory(node);
+#   else
+    return false;
+#   endif
+}
+
+
+int xmrig::Numa::currentNode()
+{
+#   if defined(__linux__) && defined(SYS_getcpu)
+    unsigned cpu  = 0;
+    unsigned node = 0;
+
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+        return static_cast<int>(node);
+    }
+#   endif
+
+    return 0;
+}
+
+
+int xmrig::Numa::nodeByIndex(size_t index)
+{
+#   ifdef __linux__
+    if (!cpuNodes.empty()) {
+        return cpuNodes[index % cpuNodes.size()];
+    }
+#   endif
+
+    return 0;
+}
+
+
+int xmrig::Numa::node(int64_t cpu)
+{
+#   ifdef __linux__
+    if (cpu >= 0 && static_cast<size_t>(cpu) < cpuToNode.size()) {
+        return cpuToNode[cpu];
+    }
+#   endif
+
+    return -1;
+}
+
+
+int xmrig::Numa::node(const void *memory)
+{
+#   if defined(__linux__) && defined(SYS_get_mempolicy)
+    int node = -1;
+
+    if (memory && syscall(SYS_get_mempolicy, &node, nullptr, 0, memory, kMpolFNode | kMpolFAddr) == 0) {
+        return node;
+    }
+#   endif
+
+    return -1;
+}
+
+
+void xmrig::Numa::init()
+{
+#   ifdef __linux__
+    DIR *dir = opendir("/sys/devices/system/node");
+    if (!dir) {
+        return;
+    }
+
+    while (dirent *entry = readdir(dir)) {
+        char *end = nullptr;
+        if (strncmp(entry->d_name, "node", 4) != 0) {
+            continue;
+        }
+
+        const long node = strtol(entry->d_name + 4, &end, 10);
+        if (end == entry->d_name + 4 || *end != '\0' || node < 0 || static_cast<size_t>(node) >= kMaxNodes) {
+            continue;
+        }
+
+        char path[64];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%ld/cpulist", node);
+
+        FILE *fp = fopen(path, "r");
+        if (!fp) {
+            continue;
+        }
+
+        char list[4096] = { 0 };
+        if (fgets(list, sizeof(list), fp)) {
+            if (static_cast<size_t>(node) >= nodeCpus.size()) {
+                nodeCpus.resize(node + 1);
+            }
+
+            parseCpuList(list, static_cast<int>(node));
+        }
+
+        fclose(fp);
+    }
+
+    closedir(dir);
+
+    // Threads are spread only over nodes the process may run on, so a mask that excludes a whole node
+    // doesn't leave threads assigned to it.
+    cpu_set_t allowed;
+    const bool masked = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+    for (size_t node = 0; node < nodeCpus.size(); ++node) {
+        for (int cpu : nodeCpus[node]) {
+            if (!masked || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed))) {
+                cpuNodes.push_back(static_cast<int>(node));
+                break;
+            }
+        }
+    }
+
+    m_nodes = cpuNodes.empty() ? 1 : cpuNodes.size();
+#   endif
+}
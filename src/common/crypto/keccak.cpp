@@ -168,7 +168,9 @@ typedef uint64_t state_t[25];
 void xmrig::keccak(const uint8_t *in, int inlen, uint8_t *md, int mdlen)
 {
     state_t st;
-    uint8_t temp[144];
+    uint64_t temp[18];
+    uint8_t *bytes = reinterpret_cast<uint8_t *>(temp);
+    uint64_t word;
     int i, rsiz, rsizw;
 
     rsiz = sizeof(state_t) == mdlen ? HASH_DATA_AREA : 200 - 2 * mdlen;
@@ -178,20 +180,21 @@ void xmrig::keccak(const uint8_t *in, int inlen, uint8_t *md, int mdlen)
 
     for ( ; inlen >= rsiz; inlen -= rsiz, in += rsiz) {
         for (i = 0; i < rsizw; i++) {
-            st[i] ^= ((uint64_t *) in)[i];
+            memcpy(&word, in + i * 8, sizeof(word));
+            st[i] ^= word;
         }
 
         xmrig::keccakf(st, KECCAK_ROUNDS);
     }
 
     // last block and padding
-    memcpy(temp, in, inlen);
-    temp[inlen++] = 1;
-    memset(temp + inlen, 0, rsiz - inlen);
-    temp[rsiz - 1] |= 0x80;
+    memcpy(bytes, in, inlen);
+    bytes[inlen++] = 1;
+    memset(bytes + inlen, 0, rsiz - inlen);
+    bytes[rsiz - 1] |= 0x80;
 
     for (i = 0; i < rsizw; i++) {
-        st[i] ^= ((uint64_t *) temp)[i];
+        st[i] ^= temp[i];
     }
 
     keccakf(st, KECCAK_ROUNDS);
@@ -80,6 +80,12 @@ public:
         CPUAffinityKey    = 1020,
         DryRunKey         = 5000,
         HugePagesKey      = 1009,
+        GigantPagesKey    = 1017,
+        ScratchOffsetKey  = 1018,
+        AlgoSwitchKey     = 1019,
+        HugetlbfsKey      = 1022,
+        YieldIntervalKey  = 1023,
+        YieldLoadKey      = 1024,
         MaxCPUUsageKey    = 1004,
         SafeKey           = 1005,
         ThreadsKey        = 't',
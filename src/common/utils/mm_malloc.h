@@ -28,4 +28,11 @@
 #include <malloc.h>
 
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#   include <mm_malloc.h>
+#elif !defined(_MSC_VER)
+#   include "3rdparty/aligned_malloc.h"
+#endif
+
+
 #endif /* __MM_MALLOC_PORTABLE_H__ */
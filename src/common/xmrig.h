@@ -56,6 +56,11 @@ enum AlgoVariant {
     AV_TRIPLE_SOFT, // --av=8  Triple hash mode (Software AES)
     AV_QUAD_SOFT,   // --av=9  Quard hash mode  (Software AES)
     AV_PENTA_SOFT,  // --av=10 Penta hash mode  (Software AES)
+    AV_OCTA,        // --av=11 Octa hash mode (cn-lite and cn-pico only)
+    AV_HEXADECA,    // --av=12 Hexadeca hash mode (cn-lite and cn-pico only)
+    AV_OCTA_SOFT,   // --av=13 Octa hash mode (Software AES, cn-lite and cn-pico only)
+    AV_HEXADECA_SOFT, // --av=14 Hexadeca hash mode (Software AES, cn-lite and cn-pico only)
+    AV_REF,         // --av=15 Reference single hash mode (portable scalar kernels, for differential testing)
     AV_MAX
 };
 
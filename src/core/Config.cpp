@@ -22,6 +22,7 @@
  *   along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <string.h>
 #include <uv.h>
 #include <inttypes.h>
@@ -46,11 +47,16 @@ xmrig::Config::Config() : xmrig::CommonConfig(),
     m_aesMode(AES_AUTO),
     m_algoVariant(AV_AUTO),
     m_assembly(ASM_AUTO),
+    m_algoSwitch(false),
+    m_gigantPages(false),
     m_hugePages(true),
     m_safe(false),
     m_shouldSave(false),
     m_maxCpuUsage(100),
-    m_priority(-1)
+    m_priority(-1),
+    m_scratchpadOffset(0),
+    m_yieldInterval(1),
+    m_yieldLoad(0)
 {
 }
 
@@ -70,6 +76,7 @@ void xmrig::Config::getJSON(rapidjson::Document &doc) const
     auto &allocator = doc.GetAllocator();
 
     doc.AddMember("algo", StringRef(algorithm().name()), allocator);
+    doc.AddMember("algo-switch", m_algoSwitch, allocator);
 
     Value api(kObjectType);
     api.AddMember("port",         apiPort(), allocator);
@@ -100,6 +107,8 @@ void xmrig::Config::getJSON(rapidjson::Document &doc) const
     doc.AddMember("cpu-priority",  priority() != -1 ? Value(priority()) : Value(kNullType), allocator);
     doc.AddMember("donate-level",  donateLevel(), allocator);
     doc.AddMember("huge-pages",    isHugePages(), allocator);
+    doc.AddMember("1gb-pages",     isGigantPages(), allocator);
+    doc.AddMember("hugetlbfs",     m_hugetlbfs.toJSON(), allocator);
     doc.AddMember("hw-aes",        m_aesMode == AES_AUTO ? Value(kNullType) : Value(m_aesMode == AES_HW), allocator);
     doc.AddMember("log-file",      logFile()             ? Value(StringRef(logFile())).Move() : Value(kNullType).Move(), allocator);
     doc.AddMember("max-cpu-usage", m_maxCpuUsage, allocator);
@@ -108,6 +117,7 @@ void xmrig::Config::getJSON(rapidjson::Document &doc) const
     doc.AddMember("retries",       m_pools.retries(), allocator);
     doc.AddMember("retry-pause",   m_pools.retryPause(), allocator);
     doc.AddMember("safe",          m_safe, allocator);
+    doc.AddMember("scratchpad-offset", static_cast<uint64_t>(m_scratchpadOffset), allocator);
 
     if (threadsMode() != Simple) {
         Value threads(kArrayType);
@@ -129,6 +139,8 @@ void xmrig::Config::getJSON(rapidjson::Document &doc) const
 #   endif
 
     doc.AddMember("watch", m_watch, allocator);
+    doc.AddMember("yield-interval", m_yieldInterval, allocator);
+    doc.AddMember("yield-load", m_yieldLoad, allocator);
 }
 
 
@@ -156,6 +168,7 @@ bool xmrig::Config::finalize()
             m_threads.list.push_back(CpuThread::createFromData(i, m_algorithm.algo(), m_threads.cpu[i], m_priority, softAES));
         }
 
+        finalizeAlgoSwitch();
         return true;
     }
 
@@ -179,6 +192,8 @@ bool xmrig::Config::finalize()
     }
 
     m_shouldSave = m_threads.mode == Automatic;
+
+    finalizeAlgoSwitch();
     return true;
 }
 
@@ -198,6 +213,14 @@ bool xmrig::Config::parseBoolean(int key, bool enable)
         m_hugePages = enable;
         break;
 
+    case GigantPagesKey: /* --1gb-pages */
+        m_gigantPages = enable;
+        break;
+
+    case AlgoSwitchKey: /* --algo-switch */
+        m_algoSwitch = enable;
+        break;
+
     case HardwareAESKey: /* hw-aes config only */
         m_aesMode = enable ? AES_HW : AES_SOFT;
         break;
@@ -226,6 +249,9 @@ bool xmrig::Config::parseString(int key, const char *arg)
     case AVKey:          /* --av */
     case MaxCPUUsageKey: /* --max-cpu-usage */
     case CPUPriorityKey: /* --cpu-priority */
+    case ScratchOffsetKey: /* --scratchpad-offset */
+    case YieldIntervalKey: /* --yield-interval */
+    case YieldLoadKey:     /* --yield-load */
         return parseUint64(key, strtol(arg, nullptr, 10));
 
     case SafeKey: /* --safe */
@@ -234,6 +260,12 @@ bool xmrig::Config::parseString(int key, const char *arg)
     case HugePagesKey: /* --no-huge-pages */
         return parseBoolean(key, false);
 
+    case GigantPagesKey: /* --1gb-pages */
+        return parseBoolean(key, true);
+
+    case AlgoSwitchKey: /* --algo-switch */
+        return parseBoolean(key, true);
+
     case ThreadsKey:  /* --threads */
         if (strncmp(arg, "all", 3) == 0) {
             m_threads.count = Cpu::info()->threads();
@@ -254,6 +286,10 @@ bool xmrig::Config::parseString(int key, const char *arg)
         break;
 #   endif
 
+    case HugetlbfsKey: /* --hugetlbfs */
+        m_hugetlbfs = arg;
+        break;
+
     default:
         break;
     }
@@ -334,6 +370,24 @@ bool xmrig::Config::parseInt(int key, int arg)
         }
         break;
 
+    case ScratchOffsetKey: /* --scratchpad-offset */
+        if (arg >= 0) {
+            m_scratchpadOffset = std::min<size_t>(static_cast<size_t>(arg), 1024 * 1024) & ~static_cast<size_t>(63);
+        }
+        break;
+
+    case YieldIntervalKey: /* --yield-interval */
+        if (arg >= 0) {
+            m_yieldInterval = static_cast<uint32_t>(arg);
+        }
+        break;
+
+    case YieldLoadKey: /* --yield-load */
+        if (arg >= 0 && arg <= 1000) {
+            m_yieldLoad = static_cast<uint32_t>(arg);
+        }
+        break;
+
     default:
         break;
     }
@@ -342,6 +396,50 @@ bool xmrig::Config::parseInt(int key, int arg)
 }
 
 
+/**
+ * Collects algorithm families every thread can also run, they are offered to the pools and workers size their
+ * scratchpads for the largest of them.
+ */
+void xmrig::Config::finalizeAlgoSwitch()
+{
+    static const Algorithm algorithms[] = {
+        Algorithm(CRYPTONIGHT,       VARIANT_2),
+        Algorithm(CRYPTONIGHT_LITE,  VARIANT_1),
+        Algorithm(CRYPTONIGHT_HEAVY, VARIANT_0),
+        Algorithm(CRYPTONIGHT_PICO,  VARIANT_TRTL)
+    };
+
+    m_switchAlgorithms.clear();
+
+    if (!m_algoSwitch) {
+        return;
+    }
+
+    for (const Algorithm &algorithm : algorithms) {
+        if (algorithm.algo() == m_algorithm.algo()) {
+            continue;
+        }
+
+        bool supported = !m_threads.list.empty();
+
+        for (const IThread *thread : m_threads.list) {
+            const CpuThread *cpu = static_cast<const CpuThread *>(thread);
+
+            if (cpu->multiway() > CpuThread::maxMultiway(algorithm.algo()) || !cpu->fn(algorithm.algo(), algorithm.variant())) {
+                supported = false;
+                break;
+            }
+        }
+
+        if (supported) {
+            m_switchAlgorithms.push_back(algorithm.algo());
+        }
+    }
+
+    m_pools.setSwitchAlgorithms(m_switchAlgorithms);
+}
+
+
 xmrig::AlgoVariant xmrig::Config::getAlgoVariant() const
 {
 #   ifndef XMRIG_NO_AEON
@@ -358,6 +456,10 @@ xmrig::AlgoVariant xmrig::Config::getAlgoVariant() const
         return static_cast<AlgoVariant>(m_algoVariant + 2);
     }
 
+    if (CpuThread::multiway(m_algoVariant) > CpuThread::maxMultiway(m_algorithm.algo())) {
+        return CpuThread::isSoftAES(m_algoVariant) ? AV_PENTA_SOFT : AV_PENTA;
+    }
+
     return m_algoVariant;
 }
 
@@ -373,6 +475,10 @@ xmrig::AlgoVariant xmrig::Config::getAlgoVariantLite() const
         return static_cast<AlgoVariant>(m_algoVariant + 2);
     }
 
+    if (CpuThread::multiway(m_algoVariant) > CpuThread::maxMultiway(m_algorithm.algo())) {
+        return CpuThread::isSoftAES(m_algoVariant) ? AV_PENTA_SOFT : AV_PENTA;
+    }
+
     return m_algoVariant;
 }
 #endif
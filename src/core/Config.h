@@ -74,13 +74,20 @@ public:
     inline AesMode aesMode() const                       { return m_aesMode; }
     inline AlgoVariant algoVariant() const               { return m_algoVariant; }
     inline Assembly assembly() const                     { return m_assembly; }
+    inline bool isAlgoSwitch() const                     { return m_algoSwitch; }
+    inline bool isGigantPages() const                    { return m_gigantPages; }
     inline bool isHugePages() const                      { return m_hugePages; }
     inline bool isShouldSave() const                     { return m_shouldSave && isAutoSave(); }
+    inline const char *hugetlbfs() const                 { return m_hugetlbfs.data(); }
     inline const std::vector<IThread *> &threads() const { return m_threads.list; }
     inline int priority() const                          { return m_priority; }
     inline int threadsCount() const                      { return m_threads.list.size(); }
     inline int64_t affinity() const                      { return m_threads.mask; }
+    inline size_t scratchpadOffset() const               { return m_scratchpadOffset; }
+    inline const std::vector<Algo> &switchAlgorithms() const { return m_switchAlgorithms; }
     inline ThreadsMode threadsMode() const               { return m_threads.mode; }
+    inline uint32_t yieldInterval() const                { return m_yieldInterval; }
+    inline uint32_t yieldLoad() const                    { return m_yieldLoad; }
 
     static Config *load(Process *process, IConfigListener *listener);
 
@@ -93,6 +100,7 @@ protected:
 
 private:
     bool parseInt(int key, int arg);
+    void finalizeAlgoSwitch();
 
     AlgoVariant getAlgoVariant() const;
 #   ifndef XMRIG_NO_AEON
@@ -115,12 +123,19 @@ private:
     AesMode m_aesMode;
     AlgoVariant m_algoVariant;
     Assembly m_assembly;
+    bool m_algoSwitch;
+    bool m_gigantPages;
     bool m_hugePages;
     bool m_safe;
     bool m_shouldSave;
     int m_maxCpuUsage;
     int m_priority;
+    size_t m_scratchpadOffset;
+    std::vector<Algo> m_switchAlgorithms;
+    String m_hugetlbfs;
     Threads m_threads;
+    uint32_t m_yieldInterval;
+    uint32_t m_yieldLoad;
 };
 
 
@@ -34,6 +34,7 @@ const static char *default_config =
 R"===(
 {
     "algo": "cryptonight",
+    "algo-switch": false,
     "api": {
         "port": 0,
         "access-token": null,
@@ -51,6 +52,8 @@ R"===(
     "cpu-priority": null,
     "donate-level": 5,
     "huge-pages": true,
+    "1gb-pages": false,
+    "hugetlbfs": null,
     "hw-aes": null,
     "log-file": null,
     "max-cpu-usage": 100,
@@ -71,9 +74,12 @@ R"===(
     "retries": 5,
     "retry-pause": 5,
     "safe": false,
+    "scratchpad-offset": 0,
     "threads": null,
     "user-agent": null,
-    "watch": false
+    "watch": false,
+    "yield-interval": 1,
+    "yield-load": 0
 }
 )===";
 #endif
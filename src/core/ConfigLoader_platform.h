@@ -65,6 +65,12 @@ static struct option const options[] = {
     { "no-color",          0, nullptr, xmrig::IConfig::ColorKey          },
     { "no-watch",          0, nullptr, xmrig::IConfig::WatchKey          },
     { "no-huge-pages",     0, nullptr, xmrig::IConfig::HugePagesKey      },
+    { "1gb-pages",         0, nullptr, xmrig::IConfig::GigantPagesKey    },
+    { "scratchpad-offset", 1, nullptr, xmrig::IConfig::ScratchOffsetKey  },
+    { "algo-switch",       0, nullptr, xmrig::IConfig::AlgoSwitchKey     },
+    { "hugetlbfs",         1, nullptr, xmrig::IConfig::HugetlbfsKey      },
+    { "yield-interval",    1, nullptr, xmrig::IConfig::YieldIntervalKey  },
+    { "yield-load",        1, nullptr, xmrig::IConfig::YieldLoadKey      },
     { "variant",           1, nullptr, xmrig::IConfig::VariantKey        },
     { "pass",              1, nullptr, xmrig::IConfig::PasswordKey       },
     { "print-time",        1, nullptr, xmrig::IConfig::PrintTimeKey      },
@@ -87,6 +93,7 @@ static struct option const options[] = {
 
 static struct option const config_options[] = {
     { "algo",          1, nullptr, xmrig::IConfig::AlgorithmKey   },
+    { "algo-switch",   0, nullptr, xmrig::IConfig::AlgoSwitchKey  },
     { "av",            1, nullptr, xmrig::IConfig::AVKey          },
     { "background",    0, nullptr, xmrig::IConfig::BackgroundKey  },
     { "colors",        0, nullptr, xmrig::IConfig::ColorKey       },
@@ -95,6 +102,8 @@ static struct option const config_options[] = {
     { "donate-level",  1, nullptr, xmrig::IConfig::DonateLevelKey },
     { "dry-run",       0, nullptr, xmrig::IConfig::DryRunKey      },
     { "huge-pages",    0, nullptr, xmrig::IConfig::HugePagesKey   },
+    { "1gb-pages",     0, nullptr, xmrig::IConfig::GigantPagesKey },
+    { "hugetlbfs",     1, nullptr, xmrig::IConfig::HugetlbfsKey   },
     { "log-file",      1, nullptr, xmrig::IConfig::LogFileKey     },
     { "max-cpu-usage", 1, nullptr, xmrig::IConfig::MaxCPUUsageKey },
     { "print-time",    1, nullptr, xmrig::IConfig::PrintTimeKey   },
@@ -108,6 +117,9 @@ static struct option const config_options[] = {
     { "hw-aes",        0, nullptr, xmrig::IConfig::HardwareAESKey },
     { "asm",           1, nullptr, xmrig::IConfig::AssemblyKey    },
     { "autosave",      0, nullptr, xmrig::IConfig::AutoSaveKey    },
+    { "scratchpad-offset", 1, nullptr, xmrig::IConfig::ScratchOffsetKey },
+    { "yield-interval",    1, nullptr, xmrig::IConfig::YieldIntervalKey },
+    { "yield-load",        1, nullptr, xmrig::IConfig::YieldLoadKey     },
     { nullptr,         0, nullptr, 0 }
 };
 
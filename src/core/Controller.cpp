@@ -28,6 +28,7 @@
 
 #include "common/config/ConfigLoader.h"
 #include "common/cpu/Cpu.h"
+#include "common/cpu/Numa.h"
 #include "common/interfaces/IControllerListener.h"
 #include "common/log/ConsoleLog.h"
 #include "common/log/FileLog.h"
@@ -98,6 +99,7 @@ xmrig::Config *xmrig::Controller::config() const
 int xmrig::Controller::init()
 {
     Cpu::init();
+    Numa::init();
 
     d_ptr->config = Config::load(d_ptr->process, this);
     if (!d_ptr->config) {
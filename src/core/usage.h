@@ -62,6 +62,12 @@ Options:\n\
       --cpu-affinity       set process affinity to CPU core(s), mask 0x3 for cores 0 and 1\n\
       --cpu-priority       set process priority (0 idle, 2 normal to 5 highest)\n\
       --no-huge-pages      disable huge pages support\n\
+      --1gb-pages          back scratchpads with 1 GB pages, falls back to 2 MB pages\n\
+      --hugetlbfs=PATH     keep scratchpads in files under PATH, reused after restart\n\
+      --scratchpad-offset=N  shift each scratchpad of a multiway thread by N bytes (multiple of 64, at most 1 MB)\n\
+      --yield-interval=N   yield the CPU after every N hash rounds, 0 never (default 1)\n\
+      --yield-load=N       yield only while other processes load more than N%% of the logical CPUs\n\
+      --algo-switch        let the pool switch to other algorithms without a restart\n\
       --no-color           disable colored output\n\
       --variant            algorithm PoW variant\n\
       --donate-level=N     donate level, default 5%% (5 minutes in 100 minutes)\n\
@@ -0,0 +1,307 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2018      Lee Clagett <https://github.com/vtnerd>
+ * Copyright 2018-2019 SChernykh   <https://github.com/SChernykh>
+ * Copyright 2016-2019 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <condition_variable>
+#include <mutex>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+
+#include "crypto/CnRCache.h"
+#include "crypto/CryptoNight_monero.h"
+#include "Mem.h"
+
+
+namespace xmrig {
+
+
+struct CnRKey
+{
+    Variant variant;
+    uint64_t height;
+    Assembly assembly;
+    size_t ways;
+    CnRCache::Compiler compile;
+
+    inline bool sameClass(const CnRKey &other) const { return variant == other.variant && assembly == other.assembly && ways == other.ways && compile == other.compile; }
+    inline bool operator==(const CnRKey &other) const { return height == other.height && sameClass(other); }
+};
+
+
+struct CnREntry
+{
+    CnRKey key;
+    uint64_t stamp;
+    uint32_t pins;
+    bool ready;
+};
+
+
+// The background thread is detached and may still be waiting when static destructors run,
+// so the objects it touches are intentionally never destroyed.
+static std::mutex &mutex              = *new std::mutex();
+static std::condition_variable &cv    = *new std::condition_variable();
+static std::vector<CnRKey> &queue     = *new std::vector<CnRKey>();
+static std::vector<CnRKey> &classes   = *new std::vector<CnRKey>();
+static bool worker      = false;
+static uint8_t *arena   = nullptr;
+static uint64_t counter = 0;
+static CnREntry entries[CnRCache::kSlots] = {};
+
+
+static size_t generate(const CnRKey &key, void *machine_code)
+{
+    V4_Instruction code[256];
+    const int code_size = key.variant == VARIANT_WOW ? v4_random_math_init<VARIANT_WOW>(code, key.height)
+                                                     : v4_random_math_init<VARIANT_4>(code, key.height);
+
+    return key.compile(code, code_size, machine_code, key.assembly);
+}
+
+
+static int find(const CnRKey &key)
+{
+    for (size_t i = 0; i < CnRCache::kSlots; ++i) {
+        if (entries[i].ready && entries[i].key == key) {
+            return static_cast<int>(i);
+        }
+    }
+
+    return -1;
+}
+
+
+static int slotOf(const void *code)
+{
+    const uint8_t *p = static_cast<const uint8_t *>(code);
+    if (!arena || p < arena || p >= arena + CnRCache::kSlotSize * CnRCache::kSlots) {
+        return -1;
+    }
+
+    return static_cast<int>((p - arena) / CnRCache::kSlotSize);
+}
+
+
+// An entry is preferred to stay while no newer entry of its class is more than two heights ahead:
+// the height being mined, the next one compiled ahead of time and the previous one, still needed by
+// a job for the old block that arrives late. Older heights are recycled first.
+static bool isProtected(const CnREntry &entry)
+{
+    for (const CnREntry &other : entries) {
+        if (other.ready && other.key.sameClass(entry.key) && other.key.height > entry.key.height + 2) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+// Pinned slots may be executing on another thread and are never recycled, kSlots means every slot is pinned.
+static size_t victim()
+{
+    size_t result = CnRCache::kSlots;
+
+    for (size_t i = 0; i < CnRCache::kSlots; ++i) {
+        if (!entries[i].ready) {
+            return i;
+        }
+
+        if (entries[i].pins == 0 && !isProtected(entries[i]) && (result == CnRCache::kSlots || entries[i].stamp < entries[result].stamp)) {
+            result = i;
+        }
+    }
+
+    if (result < CnRCache::kSlots) {
+        return result;
+    }
+
+    for (size_t i = 0; i < CnRCache::kSlots; ++i) {
+        if (entries[i].pins == 0 && (result == CnRCache::kSlots || entries[i].stamp < entries[result].stamp)) {
+            result = i;
+        }
+    }
+
+    return result;
+}
+
+
+static int compile(const CnRKey &key)
+{
+    if (!arena) {
+        arena = static_cast<uint8_t *>(Mem::allocateExecutableMemory(CnRCache::kSlotSize * CnRCache::kSlots));
+        if (!arena) {
+            return -1;
+        }
+
+        Mem::protectExecutableMemory(arena, CnRCache::kSlotSize * CnRCache::kSlots);
+    }
+
+    const size_t index = victim();
+    if (index == CnRCache::kSlots) {
+        return -1;
+    }
+
+    CnREntry &entry    = entries[index];
+    uint8_t *slot      = arena + index * CnRCache::kSlotSize;
+
+    entry.ready = false;
+
+    Mem::unprotectExecutableMemory(slot, CnRCache::kSlotSize);
+    const size_t size = generate(key, slot);
+    Mem::protectExecutableMemory(slot, CnRCache::kSlotSize);
+
+    if (size == 0) {
+        entry.stamp = 0;
+
+        return -1;
+    }
+
+    Mem::flushInstructionCache(slot, size);
+
+    entry.key   = key;
+    entry.stamp = ++counter;
+    entry.ready = true;
+
+    return static_cast<int>(index);
+}
+
+
+static void onWorker()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        cv.wait(lock, [] { return !queue.empty(); });
+
+        const CnRKey key = queue.front();
+        queue.erase(queue.begin());
+
+        if (find(key) < 0) {
+            compile(key);
+        }
+    }
+}
+
+
+static void schedule(const CnRKey &key)
+{
+    if (find(key) >= 0) {
+        return;
+    }
+
+    for (const CnRKey &pending : queue) {
+        if (pending == key) {
+            return;
+        }
+    }
+
+    if (!worker) {
+        worker = true;
+        std::thread(onWorker).detach();
+    }
+
+    queue.push_back(key);
+    cv.notify_one();
+}
+
+
+} /* namespace xmrig */
+
+
+void *xmrig::CnRCache::get(Variant variant, uint64_t height, Assembly assembly, size_t ways, Compiler compile)
+{
+    const CnRKey key = { variant, height, assembly, ways, compile };
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    bool known = false;
+    for (const CnRKey &c : classes) {
+        known = known || c.sameClass(key);
+    }
+
+    if (!known) {
+        classes.push_back(key);
+    }
+
+    void *code = nullptr;
+    int index  = find(key);
+
+    if (index < 0) {
+        index = xmrig::compile(key);
+    }
+
+    if (index >= 0) {
+        entries[index].stamp = ++counter;
+        entries[index].pins++;
+        code = arena + index * kSlotSize;
+    }
+
+    CnRKey next = key;
+    next.height = height + 1;
+    schedule(next);
+
+    return code;
+}
+
+
+void xmrig::CnRCache::release(const void *code)
+{
+    if (!code) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    const int index = slotOf(code);
+    if (index >= 0 && entries[index].pins > 0) {
+        entries[index].pins--;
+    }
+}
+
+
+void xmrig::CnRCache::prepare(Variant variant, uint64_t height)
+{
+    if (variant != VARIANT_WOW && variant != VARIANT_4) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (const CnRKey &c : classes) {
+        if (c.variant != variant) {
+            continue;
+        }
+
+        CnRKey key = c;
+        key.height = height;
+        schedule(key);
+
+        key.height = height + 1;
+        schedule(key);
+    }
+}
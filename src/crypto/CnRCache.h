@@ -0,0 +1,74 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2018      Lee Clagett <https://github.com/vtnerd>
+ * Copyright 2018-2019 SChernykh   <https://github.com/SChernykh>
+ * Copyright 2016-2019 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef XMRIG_CNRCACHE_H
+#define XMRIG_CNRCACHE_H
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+#include "common/xmrig.h"
+
+
+struct V4_Instruction;
+
+
+namespace xmrig {
+
+
+// Process wide cache of CryptoNight-R machine code.
+//
+// Every thread mining the same (variant, height, assembly, ways) shares one copy of the generated
+// code, so a new block costs a single compile instead of one per thread. Code lives in a W^X
+// arena of page aligned slots: a slot is written while read-write, then flipped to read-execute
+// and never modified again until it is recycled.
+//
+// get() pins the slot it returns until the caller hands the pointer back to release(), a pinned
+// slot is never recycled. When every slot is pinned get() returns nullptr and the caller falls
+// back to the interpreter.
+//
+// A background thread compiles the next height as soon as a height is seen, so the switch at a
+// block boundary is only a lookup.
+class CnRCache
+{
+public:
+    // Emits the program into machine_code and returns its size in bytes, 0 on failure.
+    typedef size_t (*Compiler)(const V4_Instruction *code, int code_size, void *machine_code, Assembly ASM);
+
+    constexpr static const size_t kSlotSize = 0x10000;
+    constexpr static const size_t kSlots    = 16;
+
+    static void *get(Variant variant, uint64_t height, Assembly assembly, size_t ways, Compiler compile);
+    static void release(const void *code);
+    static void prepare(Variant variant, uint64_t height);
+};
+
+
+} /* namespace xmrig */
+
+
+#endif /* XMRIG_CNRCACHE_H */
@@ -26,10 +26,11 @@
 #define XMRIG_CRYPTONIGHT_H
 
 
+#include <atomic>
 #include <stddef.h>
 #include <stdint.h>
 
-#if defined _MSC_VER || defined XMRIG_ARM
+#if defined _MSC_VER || !defined __x86_64__
 #define ABI_ATTRIBUTE
 #else
 #define ABI_ATTRIBUTE __attribute__((ms_abi))
@@ -50,7 +51,11 @@ struct cryptonight_ctx {
     alignas(16) uint8_t state[224];
     alignas(16) uint8_t *memory;
 
-    uint8_t unused[40];
+    // Set by the worker, kernels give up on the batch once *abort no longer equals sequence (a new job arrived).
+    const std::atomic<uint64_t> *abort;
+    uint64_t sequence;
+
+    uint8_t unused[24];
     const uint32_t* saes_table;
 
     cn_mainloop_fun_ms_abi generated_code;
@@ -61,4 +66,20 @@ struct cryptonight_ctx {
 };
 
 
+// Main loops poll for an abort every CN_ABORT_INTERVAL iterations, besides the checks after explode and before implode.
+constexpr const size_t CN_ABORT_INTERVAL = 8192;
+
+
+static inline bool cn_aborted(const cryptonight_ctx *ctx)
+{
+    return ctx->abort && ctx->abort->load(std::memory_order_relaxed) != ctx->sequence;
+}
+
+
+static inline bool cn_aborted(const cryptonight_ctx *ctx, size_t i)
+{
+    return (i & (CN_ABORT_INTERVAL - 1)) == (CN_ABORT_INTERVAL - 1) && cn_aborted(ctx);
+}
+
+
 #endif /* XMRIG_CRYPTONIGHT_H */
@@ -440,7 +440,7 @@ static inline void cryptonight_monero_tweak(const uint8_t* l, uint64_t idx, __m1
         _mm_store_si128((__m128i *)mem_out, _mm_xor_si128(bx0, cx));
     } else {
         __m128i tmp = _mm_xor_si128(bx0, cx);
-        mem_out[0] = _mm_cvtsi128_si64(tmp);
+        cn_store64(mem_out, 0, _mm_cvtsi128_si64(tmp));
 
         uint64_t vh = vgetq_lane_u64(tmp, 1);
 
@@ -449,7 +449,7 @@ static inline void cryptonight_monero_tweak(const uint8_t* l, uint64_t idx, __m1
         const uint8_t index = (((x >> (VARIANT == xmrig::VARIANT_XTL ? 4 : 3)) & 6) | (x & 1)) << 1;
         vh ^= ((table >> index) & 0x3) << 28;
 
-        mem_out[1] = vh;
+        cn_store64(mem_out, 1, vh);
     }
 }
 
@@ -471,7 +471,11 @@ inline void cryptonight_single_hash(const uint8_t *__restrict__ input, size_t si
 
     cn_explode_scratchpad<ALGO, MEM, SOFT_AES>((__m128i*) ctx[0]->state, (__m128i*) ctx[0]->memory);
 
-    const uint8_t* l0 = ctx[0]->memory;
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
+    uint8_t* l0 = ctx[0]->memory;
     uint64_t* h0 = reinterpret_cast<uint64_t*>(ctx[0]->state);
 
     VARIANT1_INIT(0);
@@ -486,6 +490,10 @@ inline void cryptonight_single_hash(const uint8_t *__restrict__ input, size_t si
     uint64_t idx0 = al0;
 
     for (size_t i = 0; i < ITERATIONS; i++) {
+        if (cn_aborted(ctx[0], i)) {
+            return;
+        }
+
         __m128i cx;
         if (VARIANT == xmrig::VARIANT_TUBE || !SOFT_AES) {
             cx = _mm_load_si128((__m128i *) &l0[idx0 & MASK]);
@@ -511,8 +519,8 @@ inline void cryptonight_single_hash(const uint8_t *__restrict__ input, size_t si
         idx0 = _mm_cvtsi128_si64(cx);
 
         uint64_t hi, lo, cl, ch;
-        cl = ((uint64_t*) &l0[idx0 & MASK])[0];
-        ch = ((uint64_t*) &l0[idx0 & MASK])[1];
+        cl = cn_load64(&l0[idx0 & MASK], 0);
+        ch = cn_load64(&l0[idx0 & MASK], 1);
 
         if (BASE == xmrig::VARIANT_2) {
             if ((VARIANT == xmrig::VARIANT_WOW) || (VARIANT == xmrig::VARIANT_4)) {
@@ -539,14 +547,14 @@ inline void cryptonight_single_hash(const uint8_t *__restrict__ input, size_t si
         al0 += hi;
         ah0 += lo;
 
-        ((uint64_t*)&l0[idx0 & MASK])[0] = al0;
+        cn_store64(&l0[idx0 & MASK], 0, al0);
 
         if (BASE == xmrig::VARIANT_1 && (VARIANT == xmrig::VARIANT_TUBE || VARIANT == xmrig::VARIANT_RTO)) {
-            ((uint64_t*)&l0[idx0 & MASK])[1] = ah0 ^ tweak1_2_0 ^ al0;
+            cn_store64(&l0[idx0 & MASK], 1, ah0 ^ tweak1_2_0 ^ al0);
         } else if (BASE == xmrig::VARIANT_1) {
-            ((uint64_t*)&l0[idx0 & MASK])[1] = ah0 ^ tweak1_2_0;
+            cn_store64(&l0[idx0 & MASK], 1, ah0 ^ tweak1_2_0);
         } else {
-            ((uint64_t*)&l0[idx0 & MASK])[1] = ah0;
+            cn_store64(&l0[idx0 & MASK], 1, ah0);
         }
 
         al0 ^= cl;
@@ -559,7 +567,7 @@ inline void cryptonight_single_hash(const uint8_t *__restrict__ input, size_t si
             const int32_t d   = vgetq_lane_s32(x, 2);
             const int64_t q   = n / (d | 0x5);
 
-            ((int64_t*)&l0[idx0 & MASK])[0] = n ^ q;
+            cn_store64(&l0[idx0 & MASK], 0, n ^ q);
 
             if (VARIANT == xmrig::VARIANT_XHV) {
                 idx0 = (~d) ^ q;
@@ -576,6 +584,10 @@ inline void cryptonight_single_hash(const uint8_t *__restrict__ input, size_t si
         bx0 = cx;
     }
 
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
     cn_implode_scratchpad<ALGO, MEM, SOFT_AES>((__m128i*) ctx[0]->memory, (__m128i*) ctx[0]->state);
 
     xmrig::keccakf(h0, 24);
@@ -600,10 +612,18 @@ inline void cryptonight_single_hash_gpu(const uint8_t *__restrict__ input, size_
     xmrig::keccak(input, size, ctx[0]->state);
     cn_explode_scratchpad_gpu<ALGO, MEM>(ctx[0]->state, ctx[0]->memory);
 
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
     fesetround(FE_TONEAREST);
 
     cn_gpu_inner_arm<ITERATIONS, MASK>(ctx[0]->state, ctx[0]->memory);
 
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
     cn_implode_scratchpad<xmrig::CRYPTONIGHT_HEAVY, MEM, SOFT_AES>((__m128i*) ctx[0]->memory, (__m128i*) ctx[0]->state);
 
     xmrig::keccakf((uint64_t*) ctx[0]->state, 24);
@@ -628,8 +648,8 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
     xmrig::keccak(input,        size, ctx[0]->state);
     xmrig::keccak(input + size, size, ctx[1]->state);
 
-    const uint8_t* l0 = ctx[0]->memory;
-    const uint8_t* l1 = ctx[1]->memory;
+    uint8_t* l0 = ctx[0]->memory;
+    uint8_t* l1 = ctx[1]->memory;
     uint64_t* h0 = reinterpret_cast<uint64_t*>(ctx[0]->state);
     uint64_t* h1 = reinterpret_cast<uint64_t*>(ctx[1]->state);
 
@@ -643,6 +663,10 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
     cn_explode_scratchpad<ALGO, MEM, SOFT_AES>((__m128i*) h0, (__m128i*) l0);
     cn_explode_scratchpad<ALGO, MEM, SOFT_AES>((__m128i*) h1, (__m128i*) l1);
 
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
     uint64_t al0 = h0[0] ^ h0[4];
     uint64_t al1 = h1[0] ^ h1[4];
     uint64_t ah0 = h0[1] ^ h0[5];
@@ -657,6 +681,10 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
     uint64_t idx1 = al1;
 
     for (size_t i = 0; i < ITERATIONS; i++) {
+        if (cn_aborted(ctx[0], i)) {
+            return;
+        }
+
         __m128i cx0, cx1;
         if (VARIANT == xmrig::VARIANT_TUBE || !SOFT_AES) {
             cx0 = _mm_load_si128((__m128i *) &l0[idx0 & MASK]);
@@ -690,8 +718,8 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
         idx1 = _mm_cvtsi128_si64(cx1);
 
         uint64_t hi, lo, cl, ch;
-        cl = ((uint64_t*) &l0[idx0 & MASK])[0];
-        ch = ((uint64_t*) &l0[idx0 & MASK])[1];
+        cl = cn_load64(&l0[idx0 & MASK], 0);
+        ch = cn_load64(&l0[idx0 & MASK], 1);
 
         if (BASE == xmrig::VARIANT_2) {
             if ((VARIANT == xmrig::VARIANT_WOW) || (VARIANT == xmrig::VARIANT_4)) {
@@ -718,14 +746,14 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
         al0 += hi;
         ah0 += lo;
 
-        ((uint64_t*)&l0[idx0 & MASK])[0] = al0;
+        cn_store64(&l0[idx0 & MASK], 0, al0);
 
         if (BASE == xmrig::VARIANT_1 && (VARIANT == xmrig::VARIANT_TUBE || VARIANT == xmrig::VARIANT_RTO)) {
-            ((uint64_t*)&l0[idx0 & MASK])[1] = ah0 ^ tweak1_2_0 ^ al0;
+            cn_store64(&l0[idx0 & MASK], 1, ah0 ^ tweak1_2_0 ^ al0);
         } else if (BASE == xmrig::VARIANT_1) {
-            ((uint64_t*)&l0[idx0 & MASK])[1] = ah0 ^ tweak1_2_0;
+            cn_store64(&l0[idx0 & MASK], 1, ah0 ^ tweak1_2_0);
         } else {
-            ((uint64_t*)&l0[idx0 & MASK])[1] = ah0;
+            cn_store64(&l0[idx0 & MASK], 1, ah0);
         }
 
         al0 ^= cl;
@@ -738,7 +766,7 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
             const int32_t d   = vgetq_lane_s32(x, 2);
             const int64_t q   = n / (d | 0x5);
 
-            ((int64_t*)&l0[idx0 & MASK])[0] = n ^ q;
+            cn_store64(&l0[idx0 & MASK], 0, n ^ q);
 
             if (VARIANT == xmrig::VARIANT_XHV) {
                 idx0 = (~d) ^ q;
@@ -748,8 +776,8 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
             }
         }
 
-        cl = ((uint64_t*) &l1[idx1 & MASK])[0];
-        ch = ((uint64_t*) &l1[idx1 & MASK])[1];
+        cl = cn_load64(&l1[idx1 & MASK], 0);
+        ch = cn_load64(&l1[idx1 & MASK], 1);
 
         if (BASE == xmrig::VARIANT_2) {
             if ((VARIANT == xmrig::VARIANT_WOW) || (VARIANT == xmrig::VARIANT_4)) {
@@ -776,14 +804,14 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
         al1 += hi;
         ah1 += lo;
 
-        ((uint64_t*)&l1[idx1 & MASK])[0] = al1;
+        cn_store64(&l1[idx1 & MASK], 0, al1);
 
         if (BASE == xmrig::VARIANT_1 && (VARIANT == xmrig::VARIANT_TUBE || VARIANT == xmrig::VARIANT_RTO)) {
-            ((uint64_t*)&l1[idx1 & MASK])[1] = ah1 ^ tweak1_2_1 ^ al1;
+            cn_store64(&l1[idx1 & MASK], 1, ah1 ^ tweak1_2_1 ^ al1);
         } else if (BASE == xmrig::VARIANT_1) {
-            ((uint64_t*)&l1[idx1 & MASK])[1] = ah1 ^ tweak1_2_1;
+            cn_store64(&l1[idx1 & MASK], 1, ah1 ^ tweak1_2_1);
         } else {
-            ((uint64_t*)&l1[idx1 & MASK])[1] = ah1;
+            cn_store64(&l1[idx1 & MASK], 1, ah1);
         }
 
         al1 ^= cl;
@@ -796,7 +824,7 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
             const int32_t d   = vgetq_lane_s32(x, 2);
             const int64_t q   = n / (d | 0x5);
 
-            ((int64_t*)&l1[idx1 & MASK])[0] = n ^ q;
+            cn_store64(&l1[idx1 & MASK], 0, n ^ q);
 
             if (VARIANT == xmrig::VARIANT_XHV) {
                 idx1 = (~d) ^ q;
@@ -813,6 +841,10 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
         bx10 = cx1;
     }
 
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
     cn_implode_scratchpad<ALGO, MEM, SOFT_AES>((__m128i*) l0, (__m128i*) h0);
     cn_implode_scratchpad<ALGO, MEM, SOFT_AES>((__m128i*) l1, (__m128i*) h1);
 
@@ -824,21 +856,333 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
 }
 
 
+#define CN_STEP1(c, l, ptr, idx)                      \
+    ptr = reinterpret_cast<__m128i*>(&l[idx & MASK]); \
+    if (VARIANT == xmrig::VARIANT_TUBE || !SOFT_AES) { \
+        c = _mm_load_si128(ptr);                      \
+    }
+
+
+#define CN_STEP2(part, al, ah, b0, b1, c, l, ptr, idx)                 \
+    const __m128i ax##part = _mm_set_epi64x(ah, al);                   \
+    if (VARIANT == xmrig::VARIANT_TUBE) {                              \
+        c = aes_round_tweak_div(c, ax##part);                          \
+    }                                                                  \
+    else if (SOFT_AES) {                                               \
+        c = soft_aesenc((uint32_t*) ptr, ax##part);                    \
+    } else {                                                           \
+        c = _mm_aesenc_si128(c, ax##part);                             \
+    }                                                                  \
+                                                                       \
+    if (BASE == xmrig::VARIANT_1 || BASE == xmrig::VARIANT_2) {        \
+        cryptonight_monero_tweak<VARIANT, BASE>(l, idx & MASK, ax##part, b0, b1, c); \
+    } else {                                                           \
+        _mm_store_si128(ptr, _mm_xor_si128(b0, c));                    \
+    }
+
+
+#define CN_STEP3(part, c, l, ptr, idx)                \
+    idx = _mm_cvtsi128_si64(c);                       \
+    ptr = reinterpret_cast<__m128i*>(&l[idx & MASK]); \
+    uint64_t cl##part = cn_load64(ptr, 0);          \
+    uint64_t ch##part = cn_load64(ptr, 1);
+
+
+#define CN_STEP4(part, al, ah, b0, b1, c, l, ptr, idx)  \
+    if (BASE == xmrig::VARIANT_2) {                     \
+        if ((VARIANT == xmrig::VARIANT_WOW) || (VARIANT == xmrig::VARIANT_4)) { \
+            VARIANT4_RANDOM_MATH(part, al, ah, cl##part, b0, b1); \
+            if (VARIANT == xmrig::VARIANT_4) {          \
+                al ^= r##part[2] | ((uint64_t)(r##part[3]) << 32); \
+                ah ^= r##part[0] | ((uint64_t)(r##part[1]) << 32); \
+            }                                           \
+        } else {                                        \
+            VARIANT2_INTEGER_MATH(part, cl##part, c);   \
+        }                                               \
+    }                                                   \
+    lo = __umul128(idx, cl##part, &hi);                 \
+    if (BASE == xmrig::VARIANT_2) {                     \
+        if (VARIANT == xmrig::VARIANT_4) {              \
+            VARIANT2_SHUFFLE(l, idx & MASK, ax##part, b0, b1, c, 0); \
+        } else {                                        \
+            VARIANT2_SHUFFLE2(l, idx & MASK, ax##part, b0, b1, hi, lo, (VARIANT == xmrig::VARIANT_RWZ ? 1 : 0)); \
+        }                                               \
+    }                                                   \
+    al += hi;                                           \
+    ah += lo;                                           \
+    cn_store64(ptr, 0, al);                           \
+                                                        \
+    if (BASE == xmrig::VARIANT_1 && (VARIANT == xmrig::VARIANT_TUBE || VARIANT == xmrig::VARIANT_RTO)) { \
+        cn_store64(ptr, 1, ah ^ tweak1_2_##part ^ al); \
+    } else if (BASE == xmrig::VARIANT_1) {              \
+        cn_store64(ptr, 1, ah ^ tweak1_2_##part);     \
+    } else {                                            \
+        cn_store64(ptr, 1, ah);                       \
+    }                                                   \
+                                                        \
+    al ^= cl##part;                                     \
+    ah ^= ch##part;                                     \
+    idx = al;                                           \
+                                                        \
+    if (ALGO == xmrig::CRYPTONIGHT_HEAVY) {             \
+        const int64x2_t x = vld1q_s64(reinterpret_cast<const int64_t *>(&l[idx & MASK])); \
+        const int64_t n   = vgetq_lane_s64(x, 0);       \
+        const int32_t d   = vgetq_lane_s32(x, 2);       \
+        const int64_t q   = n / (d | 0x5);              \
+        cn_store64(&l[idx & MASK], 0, n ^ q);          \
+        if (VARIANT == xmrig::VARIANT_XHV) {            \
+            idx = (~d) ^ q;                             \
+        }                                               \
+        else {                                          \
+            idx = d ^ q;                                \
+        }                                               \
+    }                                                   \
+    if (BASE == xmrig::VARIANT_2) {                     \
+        b1 = b0;                                        \
+    }                                                   \
+    b0 = c;
+
+
+#define CONST_INIT(n)                                                        \
+    VARIANT1_INIT(n);                                                        \
+    VARIANT2_INIT(n);                                                        \
+    VARIANT4_RANDOM_MATH_INIT(n);                                            \
+    uint64_t al##n   = h##n[0] ^ h##n[4];                                    \
+    uint64_t ah##n   = h##n[1] ^ h##n[5];                                    \
+    __m128i bx##n##0 = _mm_set_epi64x(h##n[3] ^ h##n[7], h##n[2] ^ h##n[6]);  \
+    __m128i bx##n##1 = _mm_set_epi64x(h##n[9] ^ h##n[11], h##n[8] ^ h##n[10]); \
+    __m128i cx##n;                                                           \
+    uint64_t idx##n  = al##n;
+
+
 template<xmrig::Algo ALGO, bool SOFT_AES, xmrig::Variant VARIANT>
 inline void cryptonight_triple_hash(const uint8_t *__restrict__ input, size_t size, uint8_t *__restrict__ output, struct cryptonight_ctx **__restrict__ ctx, uint64_t height)
 {
+    constexpr size_t MASK         = xmrig::cn_select_mask<ALGO>();
+    constexpr size_t ITERATIONS   = xmrig::cn_select_iter<ALGO, VARIANT>();
+    constexpr size_t MEM          = xmrig::cn_select_memory<ALGO>();
+    constexpr xmrig::Variant BASE = xmrig::cn_base_variant<VARIANT>();
+
+    if (BASE == xmrig::VARIANT_1 && size < 43) {
+        memset(output, 0, 32 * 3);
+        return;
+    }
+
+    for (size_t i = 0; i < 3; i++) {
+        xmrig::keccak(input + size * i, size, ctx[i]->state);
+        cn_explode_scratchpad<ALGO, MEM, SOFT_AES>((__m128i*) ctx[i]->state, (__m128i*) ctx[i]->memory);
+    }
+
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
+    uint8_t* l0  = ctx[0]->memory;
+    uint8_t* l1  = ctx[1]->memory;
+    uint8_t* l2  = ctx[2]->memory;
+    uint64_t* h0 = reinterpret_cast<uint64_t*>(ctx[0]->state);
+    uint64_t* h1 = reinterpret_cast<uint64_t*>(ctx[1]->state);
+    uint64_t* h2 = reinterpret_cast<uint64_t*>(ctx[2]->state);
+
+    CONST_INIT(0);
+    CONST_INIT(1);
+    CONST_INIT(2);
+
+    for (size_t i = 0; i < ITERATIONS; i++) {
+        if (cn_aborted(ctx[0], i)) {
+            return;
+        }
+
+        uint64_t hi, lo;
+        __m128i *ptr0, *ptr1, *ptr2;
+
+        CN_STEP1(cx0, l0, ptr0, idx0);
+        CN_STEP1(cx1, l1, ptr1, idx1);
+        CN_STEP1(cx2, l2, ptr2, idx2);
+
+        CN_STEP2(0, al0, ah0, bx00, bx01, cx0, l0, ptr0, idx0);
+        CN_STEP2(1, al1, ah1, bx10, bx11, cx1, l1, ptr1, idx1);
+        CN_STEP2(2, al2, ah2, bx20, bx21, cx2, l2, ptr2, idx2);
+
+        CN_STEP3(0, cx0, l0, ptr0, idx0);
+        CN_STEP3(1, cx1, l1, ptr1, idx1);
+        CN_STEP3(2, cx2, l2, ptr2, idx2);
+
+        CN_STEP4(0, al0, ah0, bx00, bx01, cx0, l0, ptr0, idx0);
+        CN_STEP4(1, al1, ah1, bx10, bx11, cx1, l1, ptr1, idx1);
+        CN_STEP4(2, al2, ah2, bx20, bx21, cx2, l2, ptr2, idx2);
+    }
+
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
+    for (size_t i = 0; i < 3; i++) {
+        cn_implode_scratchpad<ALGO, MEM, SOFT_AES>((__m128i*) ctx[i]->memory, (__m128i*) ctx[i]->state);
+        xmrig::keccakf(reinterpret_cast<uint64_t*>(ctx[i]->state), 24);
+        extra_hashes[ctx[i]->state[0] & 3](ctx[i]->state, 200, output + 32 * i);
+    }
 }
 
 
 template<xmrig::Algo ALGO, bool SOFT_AES, xmrig::Variant VARIANT>
 inline void cryptonight_quad_hash(const uint8_t *__restrict__ input, size_t size, uint8_t *__restrict__ output, struct cryptonight_ctx **__restrict__ ctx, uint64_t height)
 {
+    constexpr size_t MASK         = xmrig::cn_select_mask<ALGO>();
+    constexpr size_t ITERATIONS   = xmrig::cn_select_iter<ALGO, VARIANT>();
+    constexpr size_t MEM          = xmrig::cn_select_memory<ALGO>();
+    constexpr xmrig::Variant BASE = xmrig::cn_base_variant<VARIANT>();
+
+    if (BASE == xmrig::VARIANT_1 && size < 43) {
+        memset(output, 0, 32 * 4);
+        return;
+    }
+
+    for (size_t i = 0; i < 4; i++) {
+        xmrig::keccak(input + size * i, size, ctx[i]->state);
+        cn_explode_scratchpad<ALGO, MEM, SOFT_AES>((__m128i*) ctx[i]->state, (__m128i*) ctx[i]->memory);
+    }
+
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
+    uint8_t* l0  = ctx[0]->memory;
+    uint8_t* l1  = ctx[1]->memory;
+    uint8_t* l2  = ctx[2]->memory;
+    uint8_t* l3  = ctx[3]->memory;
+    uint64_t* h0 = reinterpret_cast<uint64_t*>(ctx[0]->state);
+    uint64_t* h1 = reinterpret_cast<uint64_t*>(ctx[1]->state);
+    uint64_t* h2 = reinterpret_cast<uint64_t*>(ctx[2]->state);
+    uint64_t* h3 = reinterpret_cast<uint64_t*>(ctx[3]->state);
+
+    CONST_INIT(0);
+    CONST_INIT(1);
+    CONST_INIT(2);
+    CONST_INIT(3);
+
+    for (size_t i = 0; i < ITERATIONS; i++) {
+        if (cn_aborted(ctx[0], i)) {
+            return;
+        }
+
+        uint64_t hi, lo;
+        __m128i *ptr0, *ptr1, *ptr2, *ptr3;
+
+        CN_STEP1(cx0, l0, ptr0, idx0);
+        CN_STEP1(cx1, l1, ptr1, idx1);
+        CN_STEP1(cx2, l2, ptr2, idx2);
+        CN_STEP1(cx3, l3, ptr3, idx3);
+
+        CN_STEP2(0, al0, ah0, bx00, bx01, cx0, l0, ptr0, idx0);
+        CN_STEP2(1, al1, ah1, bx10, bx11, cx1, l1, ptr1, idx1);
+        CN_STEP2(2, al2, ah2, bx20, bx21, cx2, l2, ptr2, idx2);
+        CN_STEP2(3, al3, ah3, bx30, bx31, cx3, l3, ptr3, idx3);
+
+        CN_STEP3(0, cx0, l0, ptr0, idx0);
+        CN_STEP3(1, cx1, l1, ptr1, idx1);
+        CN_STEP3(2, cx2, l2, ptr2, idx2);
+        CN_STEP3(3, cx3, l3, ptr3, idx3);
+
+        CN_STEP4(0, al0, ah0, bx00, bx01, cx0, l0, ptr0, idx0);
+        CN_STEP4(1, al1, ah1, bx10, bx11, cx1, l1, ptr1, idx1);
+        CN_STEP4(2, al2, ah2, bx20, bx21, cx2, l2, ptr2, idx2);
+        CN_STEP4(3, al3, ah3, bx30, bx31, cx3, l3, ptr3, idx3);
+    }
+
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
+    for (size_t i = 0; i < 4; i++) {
+        cn_implode_scratchpad<ALGO, MEM, SOFT_AES>((__m128i*) ctx[i]->memory, (__m128i*) ctx[i]->state);
+        xmrig::keccakf(reinterpret_cast<uint64_t*>(ctx[i]->state), 24);
+        extra_hashes[ctx[i]->state[0] & 3](ctx[i]->state, 200, output + 32 * i);
+    }
 }
 
 
 template<xmrig::Algo ALGO, bool SOFT_AES, xmrig::Variant VARIANT>
 inline void cryptonight_penta_hash(const uint8_t *__restrict__ input, size_t size, uint8_t *__restrict__ output, struct cryptonight_ctx **__restrict__ ctx, uint64_t height)
 {
+    constexpr size_t MASK         = xmrig::cn_select_mask<ALGO>();
+    constexpr size_t ITERATIONS   = xmrig::cn_select_iter<ALGO, VARIANT>();
+    constexpr size_t MEM          = xmrig::cn_select_memory<ALGO>();
+    constexpr xmrig::Variant BASE = xmrig::cn_base_variant<VARIANT>();
+
+    if (BASE == xmrig::VARIANT_1 && size < 43) {
+        memset(output, 0, 32 * 5);
+        return;
+    }
+
+    for (size_t i = 0; i < 5; i++) {
+        xmrig::keccak(input + size * i, size, ctx[i]->state);
+        cn_explode_scratchpad<ALGO, MEM, SOFT_AES>((__m128i*) ctx[i]->state, (__m128i*) ctx[i]->memory);
+    }
+
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
+    uint8_t* l0  = ctx[0]->memory;
+    uint8_t* l1  = ctx[1]->memory;
+    uint8_t* l2  = ctx[2]->memory;
+    uint8_t* l3  = ctx[3]->memory;
+    uint8_t* l4  = ctx[4]->memory;
+    uint64_t* h0 = reinterpret_cast<uint64_t*>(ctx[0]->state);
+    uint64_t* h1 = reinterpret_cast<uint64_t*>(ctx[1]->state);
+    uint64_t* h2 = reinterpret_cast<uint64_t*>(ctx[2]->state);
+    uint64_t* h3 = reinterpret_cast<uint64_t*>(ctx[3]->state);
+    uint64_t* h4 = reinterpret_cast<uint64_t*>(ctx[4]->state);
+
+    CONST_INIT(0);
+    CONST_INIT(1);
+    CONST_INIT(2);
+    CONST_INIT(3);
+    CONST_INIT(4);
+
+    for (size_t i = 0; i < ITERATIONS; i++) {
+        if (cn_aborted(ctx[0], i)) {
+            return;
+        }
+
+        uint64_t hi, lo;
+        __m128i *ptr0, *ptr1, *ptr2, *ptr3, *ptr4;
+
+        CN_STEP1(cx0, l0, ptr0, idx0);
+        CN_STEP1(cx1, l1, ptr1, idx1);
+        CN_STEP1(cx2, l2, ptr2, idx2);
+        CN_STEP1(cx3, l3, ptr3, idx3);
+        CN_STEP1(cx4, l4, ptr4, idx4);
+
+        CN_STEP2(0, al0, ah0, bx00, bx01, cx0, l0, ptr0, idx0);
+        CN_STEP2(1, al1, ah1, bx10, bx11, cx1, l1, ptr1, idx1);
+        CN_STEP2(2, al2, ah2, bx20, bx21, cx2, l2, ptr2, idx2);
+        CN_STEP2(3, al3, ah3, bx30, bx31, cx3, l3, ptr3, idx3);
+        CN_STEP2(4, al4, ah4, bx40, bx41, cx4, l4, ptr4, idx4);
+
+        CN_STEP3(0, cx0, l0, ptr0, idx0);
+        CN_STEP3(1, cx1, l1, ptr1, idx1);
+        CN_STEP3(2, cx2, l2, ptr2, idx2);
+        CN_STEP3(3, cx3, l3, ptr3, idx3);
+        CN_STEP3(4, cx4, l4, ptr4, idx4);
+
+        CN_STEP4(0, al0, ah0, bx00, bx01, cx0, l0, ptr0, idx0);
+        CN_STEP4(1, al1, ah1, bx10, bx11, cx1, l1, ptr1, idx1);
+        CN_STEP4(2, al2, ah2, bx20, bx21, cx2, l2, ptr2, idx2);
+        CN_STEP4(3, al3, ah3, bx30, bx31, cx3, l3, ptr3, idx3);
+        CN_STEP4(4, al4, ah4, bx40, bx41, cx4, l4, ptr4, idx4);
+    }
+
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
+    for (size_t i = 0; i < 5; i++) {
+        cn_implode_scratchpad<ALGO, MEM, SOFT_AES>((__m128i*) ctx[i]->memory, (__m128i*) ctx[i]->state);
+        xmrig::keccakf(reinterpret_cast<uint64_t*>(ctx[i]->state), 24);
+        extra_hashes[ctx[i]->state[0] & 3](ctx[i]->state, 200, output + 32 * i);
+    }
 }
 
 #endif /* __CRYPTONIGHT_ARM_H__ */
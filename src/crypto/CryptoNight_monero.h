@@ -28,23 +28,43 @@
 
 #include <fenv.h>
 #include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+
+// Scratchpad lines are read and written both as vectors and as 32/64-bit words. The word accesses go through
+// memcpy, which compiles to a single load or store, so they are never reordered against other accesses to the
+// same bytes under strict aliasing. The index counts words of the access size from p.
+static inline uint64_t cn_load64(const void *p, size_t index)
+{
+    uint64_t value;
+    memcpy(&value, static_cast<const uint8_t *>(p) + index * sizeof(value), sizeof(value));
+
+    return value;
+}
+
+
+static inline uint32_t cn_load32(const void *p, size_t index)
+{
+    uint32_t value;
+    memcpy(&value, static_cast<const uint8_t *>(p) + index * sizeof(value), sizeof(value));
+
+    return value;
+}
+
+
+static inline void cn_store64(void *p, size_t index, uint64_t value)
+{
+    memcpy(static_cast<uint8_t *>(p) + index * sizeof(value), &value, sizeof(value));
+}
+
 
 // VARIANT ALTERATIONS
-#ifndef XMRIG_ARM
-#   define VARIANT1_INIT(part) \
-    uint64_t tweak1_2_##part = 0; \
-    if (BASE == xmrig::VARIANT_1) { \
-        tweak1_2_##part = (*reinterpret_cast<const uint64_t*>(input + 35 + part * size) ^ \
-                          *(reinterpret_cast<const uint64_t*>(ctx[part]->state) + 24)); \
-    }
-#else
-#   define VARIANT1_INIT(part) \
+#define VARIANT1_INIT(part) \
     uint64_t tweak1_2_##part = 0; \
     if (BASE == xmrig::VARIANT_1) { \
-        memcpy(&tweak1_2_##part, input + 35 + part * size, sizeof tweak1_2_##part); \
-        tweak1_2_##part ^= *(reinterpret_cast<const uint64_t*>(ctx[part]->state) + 24); \
+        tweak1_2_##part = cn_load64(input + 35 + part * size, 0) ^ cn_load64(ctx[part]->state, 24); \
     }
-#endif
 
 #define VARIANT1_1(p) \
     if (BASE == xmrig::VARIANT_1) { \
@@ -100,8 +120,8 @@
     do { \
         const __m128i chunk1 = _mm_xor_si128(_mm_load_si128((__m128i *)((base_ptr) + ((offset) ^ 0x10))), _mm_set_epi64x(lo, hi)); \
         const __m128i chunk2 = _mm_load_si128((__m128i *)((base_ptr) + ((offset) ^ 0x20))); \
-        hi ^= ((uint64_t*)((base_ptr) + ((offset) ^ 0x20)))[0]; \
-        lo ^= ((uint64_t*)((base_ptr) + ((offset) ^ 0x20)))[1]; \
+        hi ^= cn_load64(((base_ptr) + ((offset) ^ 0x20)), 0); \
+        lo ^= cn_load64(((base_ptr) + ((offset) ^ 0x20)), 1); \
         const __m128i chunk3 = _mm_load_si128((__m128i *)((base_ptr) + ((offset) ^ 0x30))); \
         if (reverse) { \
             _mm_store_si128((__m128i *)((base_ptr) + ((offset) ^ 0x10)), _mm_add_epi64(chunk1, _b1)); \
@@ -150,8 +170,8 @@
     do { \
         const uint64x2_t chunk1 = veorq_u64(vld1q_u64((uint64_t*)((base_ptr) + ((offset) ^ 0x10))), vcombine_u64(vcreate_u64(hi), vcreate_u64(lo))); \
         const uint64x2_t chunk2 = vld1q_u64((uint64_t*)((base_ptr) + ((offset) ^ 0x20))); \
-        hi ^= ((uint64_t*)((base_ptr) + ((offset) ^ 0x20)))[0]; \
-        lo ^= ((uint64_t*)((base_ptr) + ((offset) ^ 0x20)))[1]; \
+        hi ^= cn_load64(((base_ptr) + ((offset) ^ 0x20)), 0); \
+        lo ^= cn_load64(((base_ptr) + ((offset) ^ 0x20)), 1); \
         const uint64x2_t chunk3 = vld1q_u64((uint64_t*)((base_ptr) + ((offset) ^ 0x30))); \
         if (reverse) { \
             vst1q_u64((uint64_t*)((base_ptr) + ((offset) ^ 0x10)), vaddq_u64(chunk1, vreinterpretq_u64_u8(_b1))); \
@@ -192,6 +212,13 @@
   } \
   v4_random_math_init<VARIANT>(code##part, height);\
 
+#ifdef XMRIG_PPC64
+#   define VARIANT4_RANDOM_MATH_EXEC(part) \
+    if (v4jit) { v4jit(r##part); } else { v4_random_math(code##part, r##part); }
+#else
+#   define VARIANT4_RANDOM_MATH_EXEC(part) v4_random_math(code##part, r##part)
+#endif
+
 #define VARIANT4_RANDOM_MATH(part, al, ah, cl, bx0, bx1) \
   if ((VARIANT == xmrig::VARIANT_WOW) || (VARIANT == xmrig::VARIANT_4)) { \
     cl ^= (r##part[0] + r##part[1]) | ((uint64_t)(r##part[2] + r##part[3]) << 32); \
@@ -200,7 +227,7 @@
     r##part[6] = static_cast<uint32_t>(_mm_cvtsi128_si32(bx0)); \
     r##part[7] = static_cast<uint32_t>(_mm_cvtsi128_si32(bx1)); \
     r##part[8] = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(bx1, 8))); \
-    v4jit(r##part); \
+    VARIANT4_RANDOM_MATH_EXEC(part); \
   }
 
 #endif /* XMRIG_CRYPTONIGHT_MONERO_H */
@@ -29,6 +29,7 @@
 
 #include "common/cpu/Cpu.h"
 #include "common/crypto/keccak.h"
+#include "crypto/CnRCache.h"
 #include "crypto/CryptoNight.h"
 #include "crypto/CryptoNight_constants.h"
 #include "crypto/CryptoNight_monero.h"
@@ -155,16 +156,30 @@ static inline void aes_genkey(const __m128i* memory, __m128i* k0, __m128i* k1, _
       aes_genkey_sub<0x08>(&xout0, &xout2);
       *k8 = xout0;
       *k9 = xout2;
+
+      *k0 = v_rev(*k0);
+      *k1 = v_rev(*k1);
+      *k2 = v_rev(*k2);
+      *k3 = v_rev(*k3);
+      *k4 = v_rev(*k4);
+      *k5 = v_rev(*k5);
+      *k6 = v_rev(*k6);
+      *k7 = v_rev(*k7);
+      *k8 = v_rev(*k8);
+      *k9 = v_rev(*k9);
     }
  }
 
 
 static FORCEINLINE void soft_aesenc(void* __restrict ptr, const void* __restrict key, const uint32_t* __restrict t)
 {
-    uint32_t x0 = ((const uint32_t*)(ptr))[0];
-    uint32_t x1 = ((const uint32_t*)(ptr))[1];
-    uint32_t x2 = ((const uint32_t*)(ptr))[2];
-    uint32_t x3 = ((const uint32_t*)(ptr))[3];
+    uint32_t x[4];
+    memcpy(x, ptr, sizeof(x));
+
+    uint32_t x0 = x[0];
+    uint32_t x1 = x[1];
+    uint32_t x2 = x[2];
+    uint32_t x3 = x[3];
 
     uint32_t y0 = t[x0 & 0xff]; x0 >>= 8;
     uint32_t y1 = t[x1 & 0xff]; x1 >>= 8;
@@ -189,18 +204,25 @@ static FORCEINLINE void soft_aesenc(void* __restrict ptr, const void* __restrict
     y2 ^= t[x1];
     y3 ^= t[x2];
 
-    ((uint32_t*)ptr)[0] = y0 ^ ((uint32_t*)key)[0];
-    ((uint32_t*)ptr)[1] = y1 ^ ((uint32_t*)key)[1];
-    ((uint32_t*)ptr)[2] = y2 ^ ((uint32_t*)key)[2];
-    ((uint32_t*)ptr)[3] = y3 ^ ((uint32_t*)key)[3];
+    uint32_t k[4];
+    memcpy(k, key, sizeof(k));
+
+    x[0] = y0 ^ k[0];
+    x[1] = y1 ^ k[1];
+    x[2] = y2 ^ k[2];
+    x[3] = y3 ^ k[3];
+    memcpy(ptr, x, sizeof(x));
 }
 
 static FORCEINLINE __m128i soft_aesenc(const void* __restrict ptr, const __m128i key, const uint32_t* __restrict t)
 {
-    uint32_t x0 = ((const uint32_t*)(ptr))[0];
-    uint32_t x1 = ((const uint32_t*)(ptr))[1];
-    uint32_t x2 = ((const uint32_t*)(ptr))[2];
-    uint32_t x3 = ((const uint32_t*)(ptr))[3];
+    uint32_t x[4];
+    memcpy(x, ptr, sizeof(x));
+
+    uint32_t x0 = x[0];
+    uint32_t x1 = x[1];
+    uint32_t x2 = x[2];
+    uint32_t x3 = x[3];
 
     uint32_t y0 = t[x0 & 0xff]; x0 >>= 8;
     uint32_t y1 = t[x1 & 0xff]; x1 >>= 8;
@@ -243,17 +265,25 @@ NOINLINE void aes_round<true>(__m128i key, __m128i* x0, __m128i* x1, __m128i* x2
     *x7 = soft_aesenc((uint32_t*)x7, key, (const uint32_t*)saes_table);
 }
 
+// Hardware rounds keep keys and state in vcipher-native (big-endian) byte order, aes_genkey<false>
+// returns the keys that way and aes_native converts the data only when it enters or leaves memory.
+template<bool SOFT_AES>
+static FORCEINLINE __m128i aes_native(__m128i x)
+{
+    return SOFT_AES ? x : v_rev(x);
+}
+
 template<>
 FORCEINLINE void aes_round<false>(__m128i key, __m128i* x0, __m128i* x1, __m128i* x2, __m128i* x3, __m128i* x4, __m128i* x5, __m128i* x6, __m128i* x7)
 {
-    *x0 = _mm_aesenc_si128(*x0, key);
-    *x1 = _mm_aesenc_si128(*x1, key);
-    *x2 = _mm_aesenc_si128(*x2, key);
-    *x3 = _mm_aesenc_si128(*x3, key);
-    *x4 = _mm_aesenc_si128(*x4, key);
-    *x5 = _mm_aesenc_si128(*x5, key);
-    *x6 = _mm_aesenc_si128(*x6, key);
-    *x7 = _mm_aesenc_si128(*x7, key);
+    *x0 = v_aesenc_be(*x0, key);
+    *x1 = v_aesenc_be(*x1, key);
+    *x2 = v_aesenc_be(*x2, key);
+    *x3 = v_aesenc_be(*x3, key);
+    *x4 = v_aesenc_be(*x4, key);
+    *x5 = v_aesenc_be(*x5, key);
+    *x6 = v_aesenc_be(*x6, key);
+    *x7 = v_aesenc_be(*x7, key);
 }
 
 inline void mix_and_propagate(__m128i& x0, __m128i& x1, __m128i& x2, __m128i& x3, __m128i& x4, __m128i& x5, __m128i& x6, __m128i& x7)
@@ -278,14 +308,14 @@ static inline void cn_explode_scratchpad(const __m128i *input, __m128i *output)
 
     aes_genkey<SOFT_AES>(input, &k0, &k1, &k2, &k3, &k4, &k5, &k6, &k7, &k8, &k9);
 
-    xin0 = _mm_load_si128(input + 4);
-    xin1 = _mm_load_si128(input + 5);
-    xin2 = _mm_load_si128(input + 6);
-    xin3 = _mm_load_si128(input + 7);
-    xin4 = _mm_load_si128(input + 8);
-    xin5 = _mm_load_si128(input + 9);
-    xin6 = _mm_load_si128(input + 10);
-    xin7 = _mm_load_si128(input + 11);
+    xin0 = aes_native<SOFT_AES>(_mm_load_si128(input + 4));
+    xin1 = aes_native<SOFT_AES>(_mm_load_si128(input + 5));
+    xin2 = aes_native<SOFT_AES>(_mm_load_si128(input + 6));
+    xin3 = aes_native<SOFT_AES>(_mm_load_si128(input + 7));
+    xin4 = aes_native<SOFT_AES>(_mm_load_si128(input + 8));
+    xin5 = aes_native<SOFT_AES>(_mm_load_si128(input + 9));
+    xin6 = aes_native<SOFT_AES>(_mm_load_si128(input + 10));
+    xin7 = aes_native<SOFT_AES>(_mm_load_si128(input + 11));
 
     if (ALGO == xmrig::CRYPTONIGHT_HEAVY) {
         for (size_t i = 0; i < 16; i++) {
@@ -316,14 +346,14 @@ static inline void cn_explode_scratchpad(const __m128i *input, __m128i *output)
         aes_round<SOFT_AES>(k8, &xin0, &xin1, &xin2, &xin3, &xin4, &xin5, &xin6, &xin7);
         aes_round<SOFT_AES>(k9, &xin0, &xin1, &xin2, &xin3, &xin4, &xin5, &xin6, &xin7);
 
-        _mm_store_si128(output + i + 0, xin0);
-        _mm_store_si128(output + i + 1, xin1);
-        _mm_store_si128(output + i + 2, xin2);
-        _mm_store_si128(output + i + 3, xin3);
-        _mm_store_si128(output + i + 4, xin4);
-        _mm_store_si128(output + i + 5, xin5);
-        _mm_store_si128(output + i + 6, xin6);
-        _mm_store_si128(output + i + 7, xin7);
+        _mm_store_si128(output + i + 0, aes_native<SOFT_AES>(xin0));
+        _mm_store_si128(output + i + 1, aes_native<SOFT_AES>(xin1));
+        _mm_store_si128(output + i + 2, aes_native<SOFT_AES>(xin2));
+        _mm_store_si128(output + i + 3, aes_native<SOFT_AES>(xin3));
+        _mm_store_si128(output + i + 4, aes_native<SOFT_AES>(xin4));
+        _mm_store_si128(output + i + 5, aes_native<SOFT_AES>(xin5));
+        _mm_store_si128(output + i + 6, aes_native<SOFT_AES>(xin6));
+        _mm_store_si128(output + i + 7, aes_native<SOFT_AES>(xin7));
     }
 }
 
@@ -364,25 +394,25 @@ static inline void cn_implode_scratchpad(const __m128i *input, __m128i *output)
 
     aes_genkey<SOFT_AES>(output + 2, &k0, &k1, &k2, &k3, &k4, &k5, &k6, &k7, &k8, &k9);
 
-    xout0 = _mm_load_si128(output + 4);
-    xout1 = _mm_load_si128(output + 5);
-    xout2 = _mm_load_si128(output + 6);
-    xout3 = _mm_load_si128(output + 7);
-    xout4 = _mm_load_si128(output + 8);
-    xout5 = _mm_load_si128(output + 9);
-    xout6 = _mm_load_si128(output + 10);
-    xout7 = _mm_load_si128(output + 11);
+    xout0 = aes_native<SOFT_AES>(_mm_load_si128(output + 4));
+    xout1 = aes_native<SOFT_AES>(_mm_load_si128(output + 5));
+    xout2 = aes_native<SOFT_AES>(_mm_load_si128(output + 6));
+    xout3 = aes_native<SOFT_AES>(_mm_load_si128(output + 7));
+    xout4 = aes_native<SOFT_AES>(_mm_load_si128(output + 8));
+    xout5 = aes_native<SOFT_AES>(_mm_load_si128(output + 9));
+    xout6 = aes_native<SOFT_AES>(_mm_load_si128(output + 10));
+    xout7 = aes_native<SOFT_AES>(_mm_load_si128(output + 11));
 
     for (size_t i = 0; i < MEM / sizeof(__m128i); i += 8)
     {
-        xout0 = vec_xor(_mm_load_si128(input + i + 0), xout0);
-        xout1 = vec_xor(_mm_load_si128(input + i + 1), xout1);
-        xout2 = vec_xor(_mm_load_si128(input + i + 2), xout2);
-        xout3 = vec_xor(_mm_load_si128(input + i + 3), xout3);
-        xout4 = vec_xor(_mm_load_si128(input + i + 4), xout4);
-        xout5 = vec_xor(_mm_load_si128(input + i + 5), xout5);
-        xout6 = vec_xor(_mm_load_si128(input + i + 6), xout6);
-        xout7 = vec_xor(_mm_load_si128(input + i + 7), xout7);
+        xout0 = vec_xor(aes_native<SOFT_AES>(_mm_load_si128(input + i + 0)), xout0);
+        xout1 = vec_xor(aes_native<SOFT_AES>(_mm_load_si128(input + i + 1)), xout1);
+        xout2 = vec_xor(aes_native<SOFT_AES>(_mm_load_si128(input + i + 2)), xout2);
+        xout3 = vec_xor(aes_native<SOFT_AES>(_mm_load_si128(input + i + 3)), xout3);
+        xout4 = vec_xor(aes_native<SOFT_AES>(_mm_load_si128(input + i + 4)), xout4);
+        xout5 = vec_xor(aes_native<SOFT_AES>(_mm_load_si128(input + i + 5)), xout5);
+        xout6 = vec_xor(aes_native<SOFT_AES>(_mm_load_si128(input + i + 6)), xout6);
+        xout7 = vec_xor(aes_native<SOFT_AES>(_mm_load_si128(input + i + 7)), xout7);
 
         aes_round<SOFT_AES>(k0, &xout0, &xout1, &xout2, &xout3, &xout4, &xout5, &xout6, &xout7);
         aes_round<SOFT_AES>(k1, &xout0, &xout1, &xout2, &xout3, &xout4, &xout5, &xout6, &xout7);
@@ -402,14 +432,14 @@ static inline void cn_implode_scratchpad(const __m128i *input, __m128i *output)
 
     if (ALGO == xmrig::CRYPTONIGHT_HEAVY) {
         for (size_t i = 0; i < MEM / sizeof(__m128i); i += 8) {
-            xout0 = vec_xor(_mm_load_si128(input + i + 0), xout0);
-            xout1 = vec_xor(_mm_load_si128(input + i + 1), xout1);
-            xout2 = vec_xor(_mm_load_si128(input + i + 2), xout2);
-            xout3 = vec_xor(_mm_load_si128(input + i + 3), xout3);
-            xout4 = vec_xor(_mm_load_si128(input + i + 4), xout4);
-            xout5 = vec_xor(_mm_load_si128(input + i + 5), xout5);
-            xout6 = vec_xor(_mm_load_si128(input + i + 6), xout6);
-            xout7 = vec_xor(_mm_load_si128(input + i + 7), xout7);
+            xout0 = vec_xor(aes_native<SOFT_AES>(_mm_load_si128(input + i + 0)), xout0);
+            xout1 = vec_xor(aes_native<SOFT_AES>(_mm_load_si128(input + i + 1)), xout1);
+            xout2 = vec_xor(aes_native<SOFT_AES>(_mm_load_si128(input + i + 2)), xout2);
+            xout3 = vec_xor(aes_native<SOFT_AES>(_mm_load_si128(input + i + 3)), xout3);
+            xout4 = vec_xor(aes_native<SOFT_AES>(_mm_load_si128(input + i + 4)), xout4);
+            xout5 = vec_xor(aes_native<SOFT_AES>(_mm_load_si128(input + i + 5)), xout5);
+            xout6 = vec_xor(aes_native<SOFT_AES>(_mm_load_si128(input + i + 6)), xout6);
+            xout7 = vec_xor(aes_native<SOFT_AES>(_mm_load_si128(input + i + 7)), xout7);
 
             aes_round<SOFT_AES>(k0, &xout0, &xout1, &xout2, &xout3, &xout4, &xout5, &xout6, &xout7);
             aes_round<SOFT_AES>(k1, &xout0, &xout1, &xout2, &xout3, &xout4, &xout5, &xout6, &xout7);
@@ -441,14 +471,173 @@ static inline void cn_implode_scratchpad(const __m128i *input, __m128i *output)
         }
     }
 
-    _mm_store_si128(output + 4, xout0);
-    _mm_store_si128(output + 5, xout1);
-    _mm_store_si128(output + 6, xout2);
-    _mm_store_si128(output + 7, xout3);
-    _mm_store_si128(output + 8, xout4);
-    _mm_store_si128(output + 9, xout5);
-    _mm_store_si128(output + 10, xout6);
-    _mm_store_si128(output + 11, xout7);
+    _mm_store_si128(output + 4, aes_native<SOFT_AES>(xout0));
+    _mm_store_si128(output + 5, aes_native<SOFT_AES>(xout1));
+    _mm_store_si128(output + 6, aes_native<SOFT_AES>(xout2));
+    _mm_store_si128(output + 7, aes_native<SOFT_AES>(xout3));
+    _mm_store_si128(output + 8, aes_native<SOFT_AES>(xout4));
+    _mm_store_si128(output + 9, aes_native<SOFT_AES>(xout5));
+    _mm_store_si128(output + 10, aes_native<SOFT_AES>(xout6));
+    _mm_store_si128(output + 11, aes_native<SOFT_AES>(xout7));
+}
+
+
+template<bool SOFT_AES>
+static FORCEINLINE void aes_round8(__m128i key, __m128i (&x)[8])
+{
+    aes_round<SOFT_AES>(key, &x[0], &x[1], &x[2], &x[3], &x[4], &x[5], &x[6], &x[7]);
+}
+
+
+template<bool SOFT_AES>
+static FORCEINLINE void aes_rounds_x2(const __m128i (&k0)[10], __m128i (&x0)[8], const __m128i (&k1)[10], __m128i (&x1)[8])
+{
+    aes_round8<SOFT_AES>(k0[0], x0); aes_round8<SOFT_AES>(k1[0], x1);
+    aes_round8<SOFT_AES>(k0[1], x0); aes_round8<SOFT_AES>(k1[1], x1);
+    aes_round8<SOFT_AES>(k0[2], x0); aes_round8<SOFT_AES>(k1[2], x1);
+    aes_round8<SOFT_AES>(k0[3], x0); aes_round8<SOFT_AES>(k1[3], x1);
+    aes_round8<SOFT_AES>(k0[4], x0); aes_round8<SOFT_AES>(k1[4], x1);
+    aes_round8<SOFT_AES>(k0[5], x0); aes_round8<SOFT_AES>(k1[5], x1);
+    aes_round8<SOFT_AES>(k0[6], x0); aes_round8<SOFT_AES>(k1[6], x1);
+    aes_round8<SOFT_AES>(k0[7], x0); aes_round8<SOFT_AES>(k1[7], x1);
+    aes_round8<SOFT_AES>(k0[8], x0); aes_round8<SOFT_AES>(k1[8], x1);
+    aes_round8<SOFT_AES>(k0[9], x0); aes_round8<SOFT_AES>(k1[9], x1);
+}
+
+
+template<bool SOFT_AES>
+static FORCEINLINE void aes_genkey(const __m128i* memory, __m128i (&k)[10])
+{
+    aes_genkey<SOFT_AES>(memory, &k[0], &k[1], &k[2], &k[3], &k[4], &k[5], &k[6], &k[7], &k[8], &k[9]);
+}
+
+
+static FORCEINLINE void mix_and_propagate(__m128i (&x)[8])
+{
+    mix_and_propagate(x[0], x[1], x[2], x[3], x[4], x[5], x[6], x[7]);
+}
+
+
+// Two scratchpads in one pass: a single context only has 8 independent vcipher chains, the
+// round-key chains of both contexts are interleaved so the AES units see 16.
+template<xmrig::Algo ALGO, size_t MEM, bool SOFT_AES>
+static inline void cn_explode_scratchpad_x2(const __m128i *input0, __m128i *output0, const __m128i *input1, __m128i *output1)
+{
+    __m128i x0[8], x1[8];
+    __m128i k0[10], k1[10];
+
+    aes_genkey<SOFT_AES>(input0, k0);
+    aes_genkey<SOFT_AES>(input1, k1);
+
+    for (size_t j = 0; j < 8; j++) {
+        x0[j] = aes_native<SOFT_AES>(_mm_load_si128(input0 + 4 + j));
+        x1[j] = aes_native<SOFT_AES>(_mm_load_si128(input1 + 4 + j));
+    }
+
+    if (ALGO == xmrig::CRYPTONIGHT_HEAVY) {
+        for (size_t i = 0; i < 16; i++) {
+            aes_rounds_x2<SOFT_AES>(k0, x0, k1, x1);
+
+            mix_and_propagate(x0);
+            mix_and_propagate(x1);
+        }
+    }
+
+    for (size_t i = 0; i < MEM / sizeof(__m128i); i += 8) {
+        aes_rounds_x2<SOFT_AES>(k0, x0, k1, x1);
+
+        for (size_t j = 0; j < 8; j++) {
+            _mm_store_si128(output0 + i + j, aes_native<SOFT_AES>(x0[j]));
+            _mm_store_si128(output1 + i + j, aes_native<SOFT_AES>(x1[j]));
+        }
+    }
+}
+
+
+template<xmrig::Algo ALGO, size_t MEM, bool SOFT_AES>
+static inline void cn_implode_scratchpad_x2(const __m128i *input0, __m128i *output0, const __m128i *input1, __m128i *output1)
+{
+    __m128i x0[8], x1[8];
+    __m128i k0[10], k1[10];
+
+    aes_genkey<SOFT_AES>(output0 + 2, k0);
+    aes_genkey<SOFT_AES>(output1 + 2, k1);
+
+    for (size_t j = 0; j < 8; j++) {
+        x0[j] = aes_native<SOFT_AES>(_mm_load_si128(output0 + 4 + j));
+        x1[j] = aes_native<SOFT_AES>(_mm_load_si128(output1 + 4 + j));
+    }
+
+    for (size_t i = 0; i < MEM / sizeof(__m128i); i += 8) {
+        for (size_t j = 0; j < 8; j++) {
+            x0[j] = vec_xor(aes_native<SOFT_AES>(_mm_load_si128(input0 + i + j)), x0[j]);
+            x1[j] = vec_xor(aes_native<SOFT_AES>(_mm_load_si128(input1 + i + j)), x1[j]);
+        }
+
+        aes_rounds_x2<SOFT_AES>(k0, x0, k1, x1);
+
+        if (ALGO == xmrig::CRYPTONIGHT_HEAVY) {
+            mix_and_propagate(x0);
+            mix_and_propagate(x1);
+        }
+    }
+
+    if (ALGO == xmrig::CRYPTONIGHT_HEAVY) {
+        for (size_t i = 0; i < MEM / sizeof(__m128i); i += 8) {
+            for (size_t j = 0; j < 8; j++) {
+                x0[j] = vec_xor(aes_native<SOFT_AES>(_mm_load_si128(input0 + i + j)), x0[j]);
+                x1[j] = vec_xor(aes_native<SOFT_AES>(_mm_load_si128(input1 + i + j)), x1[j]);
+            }
+
+            aes_rounds_x2<SOFT_AES>(k0, x0, k1, x1);
+
+            mix_and_propagate(x0);
+            mix_and_propagate(x1);
+        }
+
+        for (size_t i = 0; i < 16; i++) {
+            aes_rounds_x2<SOFT_AES>(k0, x0, k1, x1);
+
+            mix_and_propagate(x0);
+            mix_and_propagate(x1);
+        }
+    }
+
+    for (size_t j = 0; j < 8; j++) {
+        _mm_store_si128(output0 + 4 + j, aes_native<SOFT_AES>(x0[j]));
+        _mm_store_si128(output1 + 4 + j, aes_native<SOFT_AES>(x1[j]));
+    }
+}
+
+
+// N-way kernels explode and implode their contexts in pairs, an odd one left over takes the single path.
+template<xmrig::Algo ALGO, size_t MEM, bool SOFT_AES, size_t N>
+static inline void cn_explode_scratchpads(cryptonight_ctx **ctx)
+{
+    size_t i = 0;
+    for (; i + 1 < N; i += 2) {
+        cn_explode_scratchpad_x2<ALGO, MEM, SOFT_AES>(reinterpret_cast<__m128i*>(ctx[i]->state), reinterpret_cast<__m128i*>(ctx[i]->memory),
+                                                      reinterpret_cast<__m128i*>(ctx[i + 1]->state), reinterpret_cast<__m128i*>(ctx[i + 1]->memory));
+    }
+
+    if (i < N) {
+        cn_explode_scratchpad<ALGO, MEM, SOFT_AES>(reinterpret_cast<__m128i*>(ctx[i]->state), reinterpret_cast<__m128i*>(ctx[i]->memory));
+    }
+}
+
+
+template<xmrig::Algo ALGO, size_t MEM, bool SOFT_AES, size_t N>
+static inline void cn_implode_scratchpads(cryptonight_ctx **ctx)
+{
+    size_t i = 0;
+    for (; i + 1 < N; i += 2) {
+        cn_implode_scratchpad_x2<ALGO, MEM, SOFT_AES>(reinterpret_cast<__m128i*>(ctx[i]->memory), reinterpret_cast<__m128i*>(ctx[i]->state),
+                                                      reinterpret_cast<__m128i*>(ctx[i + 1]->memory), reinterpret_cast<__m128i*>(ctx[i + 1]->state));
+    }
+
+    if (i < N) {
+        cn_implode_scratchpad<ALGO, MEM, SOFT_AES>(reinterpret_cast<__m128i*>(ctx[i]->memory), reinterpret_cast<__m128i*>(ctx[i]->state));
+    }
 }
 
 
@@ -476,7 +665,7 @@ static inline __m128i aes_round_tweak_div(const __m128i &in, const __m128i &key)
 
 static inline __m128i int_sqrt_v2(const uint64_t n0)
 {
-     return _mm_cvtsi64_si128(SqrtV2::get(n0));
+     return _mm_cvtsi64_si128(SqrtV2::table ? SqrtV2::get(n0) : SqrtV2::compute(n0));
 }
 
 
@@ -488,7 +677,7 @@ static inline void cryptonight_monero_tweak(uint64_t* mem_out, const uint8_t* l,
         _mm_store_si128((__m128i *)mem_out, vec_xor(bx0, cx));
     } else {
         __m128i tmp = vec_xor(bx0, cx);
-        mem_out[0] = _mm_cvtsi128_si64(tmp);
+        cn_store64(mem_out, 0, _mm_cvtsi128_si64(tmp));
 
         tmp = _mm_castps_si128(_mm_movehl_ps(_mm_castsi128_ps(tmp), _mm_castsi128_ps(tmp)));
         uint64_t vh = _mm_cvtsi128_si64(tmp);
@@ -498,12 +687,35 @@ static inline void cryptonight_monero_tweak(uint64_t* mem_out, const uint8_t* l,
         const uint8_t index = (((x >> (VARIANT == xmrig::VARIANT_XTL ? 4 : 3)) & 6) | (x & 1)) << 1;
         vh ^= ((table >> index) & 0x3) << 28;
 
-        mem_out[1] = vh;
+        cn_store64(mem_out, 1, vh);
     }
 }
 
-void wow_soft_aes_compile_code(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM);
-void v4_soft_aes_compile_code(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM);
+
+// Compiles the random math fragment for xmrig::CnRCache, the fragment does not depend on
+// the number of ways so all kernels share it. If it does not fit the cache returns NULL and
+// VARIANT4_RANDOM_MATH_EXEC falls back to the interpreter.
+static size_t v4_jit_compile_code(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM)
+{
+    const uint32_t words = JIT_compile_v3(code, machine_code, INST_LEN);
+
+    return words * sizeof(uint32_t);
+}
+
+
+// Compiles the whole CN/R main loop for the single way hardware AES kernel, the loop keeps its
+// state in registers and runs the random math inline instead of calling the fragment.
+template<xmrig::Variant VARIANT>
+static size_t cn_r_jit_compile_mainloop(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM)
+{
+    const uint32_t words = JIT_compile_cn_r_mainloop(code, VARIANT == xmrig::VARIANT_WOW, machine_code, INST_LEN);
+
+    return words * sizeof(uint32_t);
+}
+
+
+size_t wow_soft_aes_compile_code(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM);
+size_t v4_soft_aes_compile_code(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM);
 
 template<xmrig::Algo ALGO, bool SOFT_AES, xmrig::Variant VARIANT>
 inline void cryptonight_single_hash(const uint8_t *__restrict__ input, size_t size, uint8_t *__restrict__ output, cryptonight_ctx **__restrict__ ctx, uint64_t height)
@@ -524,42 +736,88 @@ inline void cryptonight_single_hash(const uint8_t *__restrict__ input, size_t si
 
     cn_explode_scratchpad<ALGO, MEM, SOFT_AES>((__m128i*) ctx[0]->state, (__m128i*) ctx[0]->memory);
 
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
     uint64_t* h0 = reinterpret_cast<uint64_t*>(ctx[0]->state);
 
-#ifndef XMRIG_NO_ASM
-    if (SOFT_AES && xmrig::cn_is_cryptonight_r<VARIANT>())
-    {
+    if (!SOFT_AES && ALGO == xmrig::CRYPTONIGHT && xmrig::cn_is_cryptonight_r<VARIANT>()) {
         if (!ctx[0]->generated_code_data.match(VARIANT, height)) {
-            V4_Instruction code[256];
-            const int code_size = v4_random_math_init<VARIANT>(code, height);
+            xmrig::CnRCache::release(reinterpret_cast<const void *>(ctx[0]->generated_code));
+            ctx[0]->generated_code = reinterpret_cast<cn_mainloop_fun_ms_abi>(xmrig::CnRCache::get(VARIANT, height, xmrig::ASM_NONE, 1, cn_r_jit_compile_mainloop<VARIANT>));
+            xmrig::CnRCache::release(ctx[0]->v4jit);
+            ctx[0]->v4jit = nullptr;
+
+            // A failed compile stays unmatched, so the loop below tries the random math JIT and the next hash asks again.
+            if (ctx[0]->generated_code) {
+                ctx[0]->generated_code_data.variant = VARIANT;
+                ctx[0]->generated_code_data.height = height;
+            }
+        }
 
-            if (VARIANT == xmrig::VARIANT_WOW)
-                wow_soft_aes_compile_code(code, code_size, reinterpret_cast<void*>(ctx[0]->generated_code), xmrig::ASM_NONE);
-            else if (VARIANT == xmrig::VARIANT_4)
-                v4_soft_aes_compile_code(code, code_size, reinterpret_cast<void*>(ctx[0]->generated_code), xmrig::ASM_NONE);
+        // without the main loop the generic loop below runs the random math in the interpreter
+        if (ctx[0]->generated_code) {
+            cn_r_loop_state state;
+            cn_r_loop_state_init(&state);
+
+            state.memory     = ctx[0]->memory;
+            state.al         = h0[0] ^ h0[4];
+            state.ah         = h0[1] ^ h0[5];
+            state.bx0[0]     = h0[2] ^ h0[6];
+            state.bx0[1]     = h0[3] ^ h0[7];
+            state.bx1[0]     = h0[8] ^ h0[10];
+            state.bx1[1]     = h0[9] ^ h0[11];
+            state.r[0]       = static_cast<uint32_t>(h0[12]);
+            state.r[1]       = static_cast<uint32_t>(h0[12] >> 32);
+            state.r[2]       = static_cast<uint32_t>(h0[13]);
+            state.r[3]       = static_cast<uint32_t>(h0[13] >> 32);
+            state.mask       = MASK;
+            state.iterations = ITERATIONS;
+
+            reinterpret_cast<fn_cn_r_mainloop>(ctx[0]->generated_code)(&state);
+
+            cn_implode_scratchpad<ALGO, MEM, SOFT_AES>((__m128i*) ctx[0]->memory, (__m128i*) ctx[0]->state);
+
+            xmrig::keccakf(h0, 24);
+            extra_hashes[ctx[0]->state[0] & 3](ctx[0]->state, 200, output);
+            return;
+        }
+    }
 
+#ifndef XMRIG_NO_ASM
+    if (SOFT_AES && xmrig::cn_is_cryptonight_r<VARIANT>() && !ctx[0]->generated_code_data.match(VARIANT, height)) {
+        const xmrig::CnRCache::Compiler compile = VARIANT == xmrig::VARIANT_WOW ? wow_soft_aes_compile_code : v4_soft_aes_compile_code;
+        xmrig::CnRCache::release(reinterpret_cast<const void *>(ctx[0]->generated_code));
+        ctx[0]->generated_code = reinterpret_cast<cn_mainloop_fun_ms_abi>(xmrig::CnRCache::get(VARIANT, height, xmrig::ASM_NONE, 1, compile));
+
+        // Without code the C main loop below interprets the program and the next hash asks the cache again.
+        if (ctx[0]->generated_code) {
             ctx[0]->generated_code_data.variant = VARIANT;
             ctx[0]->generated_code_data.height = height;
         }
+    }
 
+    if (SOFT_AES && xmrig::cn_is_cryptonight_r<VARIANT>() && ctx[0]->generated_code)
+    {
         ctx[0]->saes_table = (const uint32_t*)saes_table;
         ctx[0]->generated_code(ctx[0]);
     } else {
 #endif
 
-    const uint8_t* l0 = ctx[0]->memory;
+    uint8_t* l0 = ctx[0]->memory;
 
     VARIANT1_INIT(0);
     VARIANT2_INIT(0);
     VARIANT2_SET_ROUNDING_MODE();
     VARIANT4_RANDOM_MATH_INIT(0);
     if(!ctx[0]->generated_code_data.match(VARIANT,height)){ 
-      if(ctx[0]->v4jit != NULL){
-        JIT_end(ctx[0]->v4jit); 
-      } 
-      ctx[0]->v4jit = (void*)JIT_compile_v3(code0); 
-      ctx[0]->generated_code_data.variant = VARIANT; 
-      ctx[0]->generated_code_data.height = height; 
+      xmrig::CnRCache::release(ctx[0]->v4jit);
+      ctx[0]->v4jit = xmrig::CnRCache::get(VARIANT, height, xmrig::ASM_NONE, 1, v4_jit_compile_code); 
+      if (ctx[0]->v4jit) {
+        ctx[0]->generated_code_data.variant = VARIANT;
+        ctx[0]->generated_code_data.height = height;
+      }
     } 
     fn1 v4jit = (fn1)ctx[0]->v4jit; 
 
@@ -571,6 +829,10 @@ inline void cryptonight_single_hash(const uint8_t *__restrict__ input, size_t si
     uint64_t idx0 = al0;
 
     for (size_t i = 0; i < ITERATIONS; i++) {
+        if (cn_aborted(ctx[0], i)) {
+            return;
+        }
+
         __m128i cx;
         if (VARIANT == xmrig::VARIANT_TUBE || !SOFT_AES) {
             cx = _mm_load_si128((__m128i *) &l0[idx0 & MASK]);
@@ -581,7 +843,7 @@ inline void cryptonight_single_hash(const uint8_t *__restrict__ input, size_t si
             cx = aes_round_tweak_div(cx, ax0);
         }
         else if (SOFT_AES) {
-            cx = soft_aesenc((uint32_t*)&l0[idx0 & MASK], ax0, (const uint32_t*)saes_table);
+            cx = soft_aesenc(&l0[idx0 & MASK], ax0, (const uint32_t*)saes_table);
         }
         else {
             cx = _mm_aesenc_si128(cx, ax0);
@@ -596,8 +858,8 @@ inline void cryptonight_single_hash(const uint8_t *__restrict__ input, size_t si
         idx0 = _mm_cvtsi128_si64(cx);
 
         uint64_t hi, lo, cl, ch;
-        cl = ((uint64_t*) &l0[idx0 & MASK])[0];
-        ch = ((uint64_t*) &l0[idx0 & MASK])[1];
+        cl = cn_load64(&l0[idx0 & MASK], 0);
+        ch = cn_load64(&l0[idx0 & MASK], 1);
 
         if (BASE == xmrig::VARIANT_2) {
             if ((VARIANT == xmrig::VARIANT_WOW) || (VARIANT == xmrig::VARIANT_4)) {
@@ -624,14 +886,14 @@ inline void cryptonight_single_hash(const uint8_t *__restrict__ input, size_t si
         al0 += hi;
         ah0 += lo;
 
-        ((uint64_t*)&l0[idx0 & MASK])[0] = al0;
+        cn_store64(&l0[idx0 & MASK], 0, al0);
 
         if (BASE == xmrig::VARIANT_1 && (VARIANT == xmrig::VARIANT_TUBE || VARIANT == xmrig::VARIANT_RTO)) {
-            ((uint64_t*)&l0[idx0 & MASK])[1] = ah0 ^ tweak1_2_0 ^ al0;
+            cn_store64(&l0[idx0 & MASK], 1, ah0 ^ tweak1_2_0 ^ al0);
         } else if (BASE == xmrig::VARIANT_1) {
-            ((uint64_t*)&l0[idx0 & MASK])[1] = ah0 ^ tweak1_2_0;
+            cn_store64(&l0[idx0 & MASK], 1, ah0 ^ tweak1_2_0);
         } else {
-            ((uint64_t*)&l0[idx0 & MASK])[1] = ah0;
+            cn_store64(&l0[idx0 & MASK], 1, ah0);
         }
 
         al0 ^= cl;
@@ -639,11 +901,11 @@ inline void cryptonight_single_hash(const uint8_t *__restrict__ input, size_t si
         idx0 = al0;
 
         if (ALGO == xmrig::CRYPTONIGHT_HEAVY) {
-            int64_t n = ((int64_t*)&l0[idx0 & MASK])[0];
-            int32_t d = ((int32_t*)&l0[idx0 & MASK])[2];
+            int64_t n = static_cast<int64_t>(cn_load64(&l0[idx0 & MASK], 0));
+            int32_t d = static_cast<int32_t>(cn_load32(&l0[idx0 & MASK], 2));
             int64_t q = n / (d | 0x5);
 
-            ((int64_t*)&l0[idx0 & MASK])[0] = n ^ q;
+            cn_store64(&l0[idx0 & MASK], 0, n ^ q);
 
             if (VARIANT == xmrig::VARIANT_XHV) {
                 d = ~d;
@@ -663,6 +925,10 @@ inline void cryptonight_single_hash(const uint8_t *__restrict__ input, size_t si
     }
 #endif
         
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
     cn_implode_scratchpad<ALGO, MEM, SOFT_AES>((__m128i*) ctx[0]->memory, (__m128i*) ctx[0]->state);
 
     xmrig::keccakf(h0, 24);
@@ -688,10 +954,18 @@ inline void cryptonight_single_hash_gpu(const uint8_t *__restrict__ input, size_
     xmrig::keccak(input, size, ctx[0]->state);
     cn_explode_scratchpad_gpu<ALGO, MEM>(ctx[0]->state, ctx[0]->memory);
 
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
     fesetround(FE_TONEAREST);
 
     cn_gpu_inner_altivec<ITERATIONS, MASK>(ctx[0]->state, ctx[0]->memory);
 
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
     cn_implode_scratchpad<xmrig::CRYPTONIGHT_HEAVY, MEM, SOFT_AES>((__m128i*) ctx[0]->memory, (__m128i*) ctx[0]->state);
 
     xmrig::keccakf((uint64_t*) ctx[0]->state, 24);
@@ -728,33 +1002,33 @@ extern xmrig::CpuThread::cn_mainloop_fun        cn_double_mainloop_ryzen_asm;
 extern xmrig::CpuThread::cn_mainloop_fun        cn_double_mainloop_bulldozer_asm;
 extern xmrig::CpuThread::cn_mainloop_double_fun cn_double_double_mainloop_sandybridge_asm;
 
-void wow_compile_code(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM);
-void v4_compile_code(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM);
-void wow_compile_code_double(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM);
-void v4_compile_code_double(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM);
+size_t wow_compile_code(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM);
+size_t v4_compile_code(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM);
+size_t wow_compile_code_double(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM);
+size_t v4_compile_code_double(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM);
 
 template<xmrig::Variant VARIANT>
-void cn_r_compile_code(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM)
+size_t cn_r_compile_code(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM)
 {
-    v4_compile_code(code, code_size, machine_code, ASM);
+    return v4_compile_code(code, code_size, machine_code, ASM);
 }
 
 template<xmrig::Variant VARIANT>
-void cn_r_compile_code_double(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM)
+size_t cn_r_compile_code_double(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM)
 {
-    v4_compile_code_double(code, code_size, machine_code, ASM);
+    return v4_compile_code_double(code, code_size, machine_code, ASM);
 }
 
 template<>
-void cn_r_compile_code<xmrig::VARIANT_WOW>(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM)
+size_t cn_r_compile_code<xmrig::VARIANT_WOW>(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM)
 {
-    wow_compile_code(code, code_size, machine_code, ASM);
+    return wow_compile_code(code, code_size, machine_code, ASM);
 }
 
 template<>
-void cn_r_compile_code_double<xmrig::VARIANT_WOW>(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM)
+size_t cn_r_compile_code_double<xmrig::VARIANT_WOW>(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM)
 {
-    wow_compile_code_double(code, code_size, machine_code, ASM);
+    return wow_compile_code_double(code, code_size, machine_code, ASM);
 }
 
 template<xmrig::Algo ALGO, xmrig::Variant VARIANT, xmrig::Assembly ASM>
@@ -763,9 +1037,15 @@ inline void cryptonight_single_hash_asm(const uint8_t *__restrict__ input, size_
     constexpr size_t MEM = xmrig::cn_select_memory<ALGO>();
 
     if (xmrig::cn_is_cryptonight_r<VARIANT>() && !ctx[0]->generated_code_data.match(VARIANT, height)) {
-        V4_Instruction code[256];
-        const int code_size = v4_random_math_init<VARIANT>(code, height);
-        cn_r_compile_code<VARIANT>(code, code_size, reinterpret_cast<void*>(ctx[0]->generated_code), ASM);
+        xmrig::CnRCache::release(reinterpret_cast<const void *>(ctx[0]->generated_code));
+        ctx[0]->generated_code = reinterpret_cast<cn_mainloop_fun_ms_abi>(xmrig::CnRCache::get(VARIANT, height, ASM, 1, cn_r_compile_code<VARIANT>));
+
+        // No machine code for this height yet, the C main loop interprets the program and the next hash asks the cache again.
+        if (!ctx[0]->generated_code) {
+            cryptonight_single_hash<ALGO, false, VARIANT>(input, size, output, ctx, height);
+            return;
+        }
+
         ctx[0]->generated_code_data.variant = VARIANT;
         ctx[0]->generated_code_data.height = height;
     }
@@ -773,6 +1053,10 @@ inline void cryptonight_single_hash_asm(const uint8_t *__restrict__ input, size_
     xmrig::keccak(input, size, ctx[0]->state);
     cn_explode_scratchpad<ALGO, MEM, false>(reinterpret_cast<__m128i*>(ctx[0]->state), reinterpret_cast<__m128i*>(ctx[0]->memory));
 
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
     if (VARIANT == xmrig::VARIANT_2) {
         if (ASM == xmrig::ASM_INTEL) {
             cnv2_mainloop_ivybridge_asm(ctx[0]);
@@ -835,21 +1119,34 @@ inline void cryptonight_single_hash_asm(const uint8_t *__restrict__ input, size_
         ctx[0]->generated_code(ctx[0]);
     }
 
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
     cn_implode_scratchpad<ALGO, MEM, false>(reinterpret_cast<__m128i*>(ctx[0]->memory), reinterpret_cast<__m128i*>(ctx[0]->state));
     xmrig::keccakf(reinterpret_cast<uint64_t*>(ctx[0]->state), 24);
     extra_hashes[ctx[0]->state[0] & 3](ctx[0]->state, 200, output);
 }
 
 
+template<xmrig::Algo ALGO, bool SOFT_AES, xmrig::Variant VARIANT>
+inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t size, uint8_t *__restrict__ output, cryptonight_ctx **__restrict__ ctx, uint64_t height);
+
+
 template<xmrig::Algo ALGO, xmrig::Variant VARIANT, xmrig::Assembly ASM>
 inline void cryptonight_double_hash_asm(const uint8_t *__restrict__ input, size_t size, uint8_t *__restrict__ output, cryptonight_ctx **__restrict__ ctx, uint64_t height)
 {
     constexpr size_t MEM = xmrig::cn_select_memory<ALGO>();
 
     if (xmrig::cn_is_cryptonight_r<VARIANT>() && !ctx[0]->generated_code_double_data.match(VARIANT, height)) {
-        V4_Instruction code[256];
-        const int code_size = v4_random_math_init<VARIANT>(code, height);
-        cn_r_compile_code_double<VARIANT>(code, code_size, reinterpret_cast<void*>(ctx[0]->generated_code_double), ASM);
+        xmrig::CnRCache::release(reinterpret_cast<const void *>(ctx[0]->generated_code_double));
+        ctx[0]->generated_code_double = reinterpret_cast<cn_mainloop_double_fun_ms_abi>(xmrig::CnRCache::get(VARIANT, height, ASM, 2, cn_r_compile_code_double<VARIANT>));
+
+        if (!ctx[0]->generated_code_double) {
+            cryptonight_double_hash<ALGO, false, VARIANT>(input, size, output, ctx, height);
+            return;
+        }
+
         ctx[0]->generated_code_double_data.variant = VARIANT;
         ctx[0]->generated_code_double_data.height = height;
     }
@@ -857,8 +1154,11 @@ inline void cryptonight_double_hash_asm(const uint8_t *__restrict__ input, size_
     xmrig::keccak(input,        size, ctx[0]->state);
     xmrig::keccak(input + size, size, ctx[1]->state);
 
-    cn_explode_scratchpad<ALGO, MEM, false>(reinterpret_cast<__m128i*>(ctx[0]->state), reinterpret_cast<__m128i*>(ctx[0]->memory));
-    cn_explode_scratchpad<ALGO, MEM, false>(reinterpret_cast<__m128i*>(ctx[1]->state), reinterpret_cast<__m128i*>(ctx[1]->memory));
+    cn_explode_scratchpads<ALGO, MEM, false, 2>(ctx);
+
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
 
     if (VARIANT == xmrig::VARIANT_2) {
         cnv2_double_mainloop_sandybridge_asm(ctx[0], ctx[1]);
@@ -882,8 +1182,11 @@ inline void cryptonight_double_hash_asm(const uint8_t *__restrict__ input, size_
         ctx[0]->generated_code_double(ctx[0], ctx[1]);
     }
 
-    cn_implode_scratchpad<ALGO, MEM, false>(reinterpret_cast<__m128i*>(ctx[0]->memory), reinterpret_cast<__m128i*>(ctx[0]->state));
-    cn_implode_scratchpad<ALGO, MEM, false>(reinterpret_cast<__m128i*>(ctx[1]->memory), reinterpret_cast<__m128i*>(ctx[1]->state));
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
+    cn_implode_scratchpads<ALGO, MEM, false, 2>(ctx);
 
     xmrig::keccakf(reinterpret_cast<uint64_t*>(ctx[0]->state), 24);
     xmrig::keccakf(reinterpret_cast<uint64_t*>(ctx[1]->state), 24);
@@ -910,8 +1213,8 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
     xmrig::keccak(input,        size, ctx[0]->state);
     xmrig::keccak(input + size, size, ctx[1]->state);
 
-    const uint8_t* l0 = ctx[0]->memory;
-    const uint8_t* l1 = ctx[1]->memory;
+    uint8_t* l0 = ctx[0]->memory;
+    uint8_t* l1 = ctx[1]->memory;
     uint64_t* h0 = reinterpret_cast<uint64_t*>(ctx[0]->state);
     uint64_t* h1 = reinterpret_cast<uint64_t*>(ctx[1]->state);
 
@@ -923,17 +1226,20 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
     VARIANT4_RANDOM_MATH_INIT(0);
     VARIANT4_RANDOM_MATH_INIT(1);
     if(!ctx[0]->generated_code_data.match(VARIANT,height)){ 
-      if(ctx[0]->v4jit != NULL) {
-        JIT_end(ctx[0]->v4jit); 
-      } 
-      ctx[0]->v4jit = (void*)JIT_compile_v3(code0); 
-      ctx[0]->generated_code_data.variant = VARIANT; 
-      ctx[0]->generated_code_data.height = height; 
+      xmrig::CnRCache::release(ctx[0]->v4jit);
+      ctx[0]->v4jit = xmrig::CnRCache::get(VARIANT, height, xmrig::ASM_NONE, 1, v4_jit_compile_code); 
+      if (ctx[0]->v4jit) {
+        ctx[0]->generated_code_data.variant = VARIANT;
+        ctx[0]->generated_code_data.height = height;
+      }
     } 
     fn1 v4jit = (fn1)ctx[0]->v4jit;
 
-    cn_explode_scratchpad<ALGO, MEM, SOFT_AES>((__m128i*) h0, (__m128i*) l0);
-    cn_explode_scratchpad<ALGO, MEM, SOFT_AES>((__m128i*) h1, (__m128i*) l1);
+    cn_explode_scratchpad_x2<ALGO, MEM, SOFT_AES>((__m128i*) h0, (__m128i*) l0, (__m128i*) h1, (__m128i*) l1);
+
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
 
     uint64_t al0 = h0[0] ^ h0[4];
     uint64_t al1 = h1[0] ^ h1[4];
@@ -949,6 +1255,10 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
     uint64_t idx1 = al1;
 
     for (size_t i = 0; i < ITERATIONS; i++) {
+        if (cn_aborted(ctx[0], i)) {
+            return;
+        }
+
         __m128i cx0, cx1;
         if (VARIANT == xmrig::VARIANT_TUBE || !SOFT_AES) {
             cx0 = _mm_load_si128((__m128i *) &l0[idx0 & MASK]);
@@ -962,8 +1272,8 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
             cx1 = aes_round_tweak_div(cx1, ax1);
         }
         else if (SOFT_AES) {
-            cx0 = soft_aesenc((uint32_t*)&l0[idx0 & MASK], ax0, (const uint32_t*)saes_table);
-            cx1 = soft_aesenc((uint32_t*)&l1[idx1 & MASK], ax1, (const uint32_t*)saes_table);
+            cx0 = soft_aesenc(&l0[idx0 & MASK], ax0, (const uint32_t*)saes_table);
+            cx1 = soft_aesenc(&l1[idx1 & MASK], ax1, (const uint32_t*)saes_table);
         }
         else {
             cx0 = _mm_aesenc_si128(cx0, ax0);
@@ -982,8 +1292,8 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
         idx1 = _mm_cvtsi128_si64(cx1);
 
         uint64_t hi, lo, cl, ch;
-        cl = ((uint64_t*) &l0[idx0 & MASK])[0];
-        ch = ((uint64_t*) &l0[idx0 & MASK])[1];
+        cl = cn_load64(&l0[idx0 & MASK], 0);
+        ch = cn_load64(&l0[idx0 & MASK], 1);
 
         if (BASE == xmrig::VARIANT_2) {
             if ((VARIANT == xmrig::VARIANT_WOW) || (VARIANT == xmrig::VARIANT_4)) {
@@ -1010,14 +1320,14 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
         al0 += hi;
         ah0 += lo;
 
-        ((uint64_t*)&l0[idx0 & MASK])[0] = al0;
+        cn_store64(&l0[idx0 & MASK], 0, al0);
 
         if (BASE == xmrig::VARIANT_1 && (VARIANT == xmrig::VARIANT_TUBE || VARIANT == xmrig::VARIANT_RTO)) {
-            ((uint64_t*) &l0[idx0 & MASK])[1] = ah0 ^ tweak1_2_0 ^ al0;
+            cn_store64(&l0[idx0 & MASK], 1, ah0 ^ tweak1_2_0 ^ al0);
         } else if (BASE == xmrig::VARIANT_1) {
-            ((uint64_t*) &l0[idx0 & MASK])[1] = ah0 ^ tweak1_2_0;
+            cn_store64(&l0[idx0 & MASK], 1, ah0 ^ tweak1_2_0);
         } else {
-            ((uint64_t*) &l0[idx0 & MASK])[1] = ah0;
+            cn_store64(&l0[idx0 & MASK], 1, ah0);
         }
 
         al0 ^= cl;
@@ -1025,11 +1335,11 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
         idx0 = al0;
 
         if (ALGO == xmrig::CRYPTONIGHT_HEAVY) {
-            int64_t n = ((int64_t*)&l0[idx0 & MASK])[0];
-            int32_t d = ((int32_t*)&l0[idx0 & MASK])[2];
+            int64_t n = static_cast<int64_t>(cn_load64(&l0[idx0 & MASK], 0));
+            int32_t d = static_cast<int32_t>(cn_load32(&l0[idx0 & MASK], 2));
             int64_t q = n / (d | 0x5);
 
-            ((int64_t*)&l0[idx0 & MASK])[0] = n ^ q;
+            cn_store64(&l0[idx0 & MASK], 0, n ^ q);
 
             if (VARIANT == xmrig::VARIANT_XHV) {
                 d = ~d;
@@ -1038,8 +1348,8 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
             idx0 = d ^ q;
         }
 
-        cl = ((uint64_t*) &l1[idx1 & MASK])[0];
-        ch = ((uint64_t*) &l1[idx1 & MASK])[1];
+        cl = cn_load64(&l1[idx1 & MASK], 0);
+        ch = cn_load64(&l1[idx1 & MASK], 1);
 
         if (BASE == xmrig::VARIANT_2) {
             if ((VARIANT == xmrig::VARIANT_WOW) || (VARIANT == xmrig::VARIANT_4)) {
@@ -1066,14 +1376,14 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
         al1 += hi;
         ah1 += lo;
 
-        ((uint64_t*)&l1[idx1 & MASK])[0] = al1;
+        cn_store64(&l1[idx1 & MASK], 0, al1);
 
         if (BASE == xmrig::VARIANT_1 && (VARIANT == xmrig::VARIANT_TUBE || VARIANT == xmrig::VARIANT_RTO)) {
-            ((uint64_t*)&l1[idx1 & MASK])[1] = ah1 ^ tweak1_2_1 ^ al1;
+            cn_store64(&l1[idx1 & MASK], 1, ah1 ^ tweak1_2_1 ^ al1);
         } else if (BASE == xmrig::VARIANT_1) {
-            ((uint64_t*)&l1[idx1 & MASK])[1] = ah1 ^ tweak1_2_1;
+            cn_store64(&l1[idx1 & MASK], 1, ah1 ^ tweak1_2_1);
         } else {
-            ((uint64_t*)&l1[idx1 & MASK])[1] = ah1;
+            cn_store64(&l1[idx1 & MASK], 1, ah1);
         }
 
         al1 ^= cl;
@@ -1081,11 +1391,11 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
         idx1 = al1;
 
         if (ALGO == xmrig::CRYPTONIGHT_HEAVY) {
-            int64_t n = ((int64_t*)&l1[idx1 & MASK])[0];
-            int32_t d = ((int32_t*)&l1[idx1 & MASK])[2];
+            int64_t n = static_cast<int64_t>(cn_load64(&l1[idx1 & MASK], 0));
+            int32_t d = static_cast<int32_t>(cn_load32(&l1[idx1 & MASK], 2));
             int64_t q = n / (d | 0x5);
 
-            ((int64_t*)&l1[idx1 & MASK])[0] = n ^ q;
+            cn_store64(&l1[idx1 & MASK], 0, n ^ q);
 
             if (VARIANT == xmrig::VARIANT_XHV) {
                 d = ~d;
@@ -1103,8 +1413,11 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
         bx10 = cx1;
     }
 
-    cn_implode_scratchpad<ALGO, MEM, SOFT_AES>((__m128i*) l0, (__m128i*) h0);
-    cn_implode_scratchpad<ALGO, MEM, SOFT_AES>((__m128i*) l1, (__m128i*) h1);
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
+    cn_implode_scratchpad_x2<ALGO, MEM, SOFT_AES>((__m128i*) l0, (__m128i*) h0, (__m128i*) l1, (__m128i*) h1);
 
     xmrig::keccakf(h0, 24);
     xmrig::keccakf(h1, 24);
@@ -1139,8 +1452,8 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
 #define CN_STEP3(part, a, b0, b1, c, l, ptr, idx)     \
     idx = _mm_cvtsi128_si64(c);                       \
     ptr = reinterpret_cast<__m128i*>(&l[idx & MASK]); \
-    uint64_t cl##part = ((uint64_t*)ptr)[0];          \
-    uint64_t ch##part = ((uint64_t*)ptr)[1];
+    uint64_t cl##part = cn_load64(ptr, 0);          \
+    uint64_t ch##part = cn_load64(ptr, 1);
 
 
 #define CN_STEP4(part, a, b0, b1, c, l, mc, ptr, idx)   \
@@ -1176,7 +1489,7 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
                                                         \
         if (VARIANT == xmrig::VARIANT_TUBE ||           \
             VARIANT == xmrig::VARIANT_RTO) {            \
-            ((uint64_t*)ptr)[1] ^= ((uint64_t*)ptr)[0]; \
+            cn_store64(ptr, 1, cn_load64(ptr, 1) ^ cn_load64(ptr, 0)); \
         }                                               \
     } else {                                            \
         _mm_store_si128(ptr, a);                        \
@@ -1186,10 +1499,10 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
     idx = _mm_cvtsi128_si64(a);                         \
                                                         \
     if (ALGO == xmrig::CRYPTONIGHT_HEAVY) {             \
-        int64_t n = ((int64_t*)&l[idx & MASK])[0];      \
-        int32_t d = ((int32_t*)&l[idx & MASK])[2];      \
+        int64_t n = static_cast<int64_t>(cn_load64(&l[idx & MASK], 0));      \
+        int32_t d = static_cast<int32_t>(cn_load32(&l[idx & MASK], 2));      \
         int64_t q = n / (d | 0x5);                      \
-        ((int64_t*)&l[idx & MASK])[0] = n ^ q;          \
+        cn_store64(&l[idx & MASK], 0, n ^ q);          \
         if (VARIANT == xmrig::VARIANT_XHV) {            \
             d = ~d;                                     \
         }                                               \
@@ -1207,8 +1520,7 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
     __m128i division_result_xmm_##n;                                                             \
     __m128i sqrt_result_xmm_##n;                                                                 \
     if (BASE == xmrig::VARIANT_1) {                                                              \
-        mc##n = _mm_set_epi64x(*reinterpret_cast<const uint64_t*>(input + n * size + 35) ^       \
-                               *(reinterpret_cast<const uint64_t*>((ctx)->state) + 24), 0);      \
+        mc##n = _mm_set_epi64x(cn_load64(input + n * size + 35, 0) ^ cn_load64((ctx)->state, 24), 0); \
     }                                                                                            \
     if (BASE == xmrig::VARIANT_2) {                                                              \
         division_result_xmm_##n = _mm_cvtsi64_si128(h##n[12]);                                   \
@@ -1236,7 +1548,12 @@ inline void cryptonight_triple_hash(const uint8_t *__restrict__ input, size_t si
 
     for (size_t i = 0; i < 3; i++) {
         xmrig::keccak(input + size * i, size, ctx[i]->state);
-        cn_explode_scratchpad<ALGO, MEM, SOFT_AES>(reinterpret_cast<__m128i*>(ctx[i]->state), reinterpret_cast<__m128i*>(ctx[i]->memory));
+    }
+
+    cn_explode_scratchpads<ALGO, MEM, SOFT_AES, 3>(ctx);
+
+    if (cn_aborted(ctx[0])) {
+        return;
     }
 
     uint8_t* l0  = ctx[0]->memory;
@@ -1250,12 +1567,12 @@ inline void cryptonight_triple_hash(const uint8_t *__restrict__ input, size_t si
     CONST_INIT(ctx[1], 1);
     CONST_INIT(ctx[2], 2);
     if(!ctx[0]->generated_code_data.match(VARIANT,height)){ 
-      if(ctx[0]->v4jit != NULL) {
-        JIT_end(ctx[0]->v4jit); 
-      } 
-      ctx[0]->v4jit = (void*)JIT_compile_v3(code0); 
-      ctx[0]->generated_code_data.variant = VARIANT; 
-      ctx[0]->generated_code_data.height = height; 
+      xmrig::CnRCache::release(ctx[0]->v4jit);
+      ctx[0]->v4jit = xmrig::CnRCache::get(VARIANT, height, xmrig::ASM_NONE, 1, v4_jit_compile_code); 
+      if (ctx[0]->v4jit) {
+        ctx[0]->generated_code_data.variant = VARIANT;
+        ctx[0]->generated_code_data.height = height;
+      }
     } 
     fn1 v4jit = (fn1)ctx[0]->v4jit;
     VARIANT2_SET_ROUNDING_MODE();
@@ -1266,6 +1583,10 @@ inline void cryptonight_triple_hash(const uint8_t *__restrict__ input, size_t si
     idx2 = _mm_cvtsi128_si64(ax2);
 
     for (size_t i = 0; i < ITERATIONS; i++) {
+        if (cn_aborted(ctx[0], i)) {
+            return;
+        }
+
         uint64_t hi, lo;
         __m128i *ptr0, *ptr1, *ptr2;
 
@@ -1286,8 +1607,13 @@ inline void cryptonight_triple_hash(const uint8_t *__restrict__ input, size_t si
         CN_STEP4(2, ax2, bx20, bx21, cx2, l2, mc2, ptr2, idx2);
     }
 
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
+    cn_implode_scratchpads<ALGO, MEM, SOFT_AES, 3>(ctx);
+
     for (size_t i = 0; i < 3; i++) {
-        cn_implode_scratchpad<ALGO, MEM, SOFT_AES>(reinterpret_cast<__m128i*>(ctx[i]->memory), reinterpret_cast<__m128i*>(ctx[i]->state));
         xmrig::keccakf(reinterpret_cast<uint64_t*>(ctx[i]->state), 24);
         extra_hashes[ctx[i]->state[0] & 3](ctx[i]->state, 200, output + 32 * i);
     }
@@ -1309,7 +1635,12 @@ inline void cryptonight_quad_hash(const uint8_t *__restrict__ input, size_t size
 
     for (size_t i = 0; i < 4; i++) {
         xmrig::keccak(input + size * i, size, ctx[i]->state);
-        cn_explode_scratchpad<ALGO, MEM, SOFT_AES>(reinterpret_cast<__m128i*>(ctx[i]->state), reinterpret_cast<__m128i*>(ctx[i]->memory));
+    }
+
+    cn_explode_scratchpads<ALGO, MEM, SOFT_AES, 4>(ctx);
+
+    if (cn_aborted(ctx[0])) {
+        return;
     }
 
     uint8_t* l0  = ctx[0]->memory;
@@ -1326,12 +1657,12 @@ inline void cryptonight_quad_hash(const uint8_t *__restrict__ input, size_t size
     CONST_INIT(ctx[2], 2);
     CONST_INIT(ctx[3], 3);
     if(!ctx[0]->generated_code_data.match(VARIANT,height)){ 
-      if(ctx[0]->v4jit != NULL) {
-        JIT_end(ctx[0]->v4jit); 
-      } 
-      ctx[0]->v4jit = (void*)JIT_compile_v3(code0); 
-      ctx[0]->generated_code_data.variant = VARIANT; 
-      ctx[0]->generated_code_data.height = height; 
+      xmrig::CnRCache::release(ctx[0]->v4jit);
+      ctx[0]->v4jit = xmrig::CnRCache::get(VARIANT, height, xmrig::ASM_NONE, 1, v4_jit_compile_code); 
+      if (ctx[0]->v4jit) {
+        ctx[0]->generated_code_data.variant = VARIANT;
+        ctx[0]->generated_code_data.height = height;
+      }
     } 
     fn1 v4jit = (fn1)ctx[0]->v4jit;
 
@@ -1345,6 +1676,10 @@ inline void cryptonight_quad_hash(const uint8_t *__restrict__ input, size_t size
 
     for (size_t i = 0; i < ITERATIONS; i++)
     {
+        if (cn_aborted(ctx[0], i)) {
+            return;
+        }
+
         uint64_t hi, lo;
         __m128i *ptr0, *ptr1, *ptr2, *ptr3;
 
@@ -1369,8 +1704,13 @@ inline void cryptonight_quad_hash(const uint8_t *__restrict__ input, size_t size
         CN_STEP4(3, ax3, bx30, bx31, cx3, l3, mc3, ptr3, idx3);
     }
 
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
+    cn_implode_scratchpads<ALGO, MEM, SOFT_AES, 4>(ctx);
+
     for (size_t i = 0; i < 4; i++) {
-        cn_implode_scratchpad<ALGO, MEM, SOFT_AES>(reinterpret_cast<__m128i*>(ctx[i]->memory), reinterpret_cast<__m128i*>(ctx[i]->state));
         xmrig::keccakf(reinterpret_cast<uint64_t*>(ctx[i]->state), 24);
         extra_hashes[ctx[i]->state[0] & 3](ctx[i]->state, 200, output + 32 * i);
     }
@@ -1392,7 +1732,12 @@ inline void cryptonight_penta_hash(const uint8_t *__restrict__ input, size_t siz
 
     for (size_t i = 0; i < 5; i++) {
         xmrig::keccak(input + size * i, size, ctx[i]->state);
-        cn_explode_scratchpad<ALGO, MEM, SOFT_AES>(reinterpret_cast<__m128i*>(ctx[i]->state), reinterpret_cast<__m128i*>(ctx[i]->memory));
+    }
+
+    cn_explode_scratchpads<ALGO, MEM, SOFT_AES, 5>(ctx);
+
+    if (cn_aborted(ctx[0])) {
+        return;
     }
 
     uint8_t* l0  = ctx[0]->memory;
@@ -1412,12 +1757,12 @@ inline void cryptonight_penta_hash(const uint8_t *__restrict__ input, size_t siz
     CONST_INIT(ctx[3], 3);
     CONST_INIT(ctx[4], 4);
     if(!ctx[0]->generated_code_data.match(VARIANT,height)){ 
-      if(ctx[0]->v4jit != NULL) {
-        JIT_end(ctx[0]->v4jit); 
-      } 
-      ctx[0]->v4jit = (void*)JIT_compile_v3(code0); 
-      ctx[0]->generated_code_data.variant = VARIANT; 
-      ctx[0]->generated_code_data.height = height; 
+      xmrig::CnRCache::release(ctx[0]->v4jit);
+      ctx[0]->v4jit = xmrig::CnRCache::get(VARIANT, height, xmrig::ASM_NONE, 1, v4_jit_compile_code); 
+      if (ctx[0]->v4jit) {
+        ctx[0]->generated_code_data.variant = VARIANT;
+        ctx[0]->generated_code_data.height = height;
+      }
     } 
     fn1 v4jit = (fn1)ctx[0]->v4jit;
 
@@ -1432,6 +1777,10 @@ inline void cryptonight_penta_hash(const uint8_t *__restrict__ input, size_t siz
 
     for (size_t i = 0; i < ITERATIONS; i++)
     {
+        if (cn_aborted(ctx[0], i)) {
+            return;
+        }
+
         uint64_t hi, lo;
         __m128i *ptr0, *ptr1, *ptr2, *ptr3, *ptr4;
 
@@ -1460,8 +1809,151 @@ inline void cryptonight_penta_hash(const uint8_t *__restrict__ input, size_t siz
         CN_STEP4(4, ax4, bx40, bx41, cx4, l4, mc4, ptr4, idx4);
     }
 
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
+    cn_implode_scratchpads<ALGO, MEM, SOFT_AES, 5>(ctx);
+
     for (size_t i = 0; i < 5; i++) {
-        cn_implode_scratchpad<ALGO, MEM, SOFT_AES>(reinterpret_cast<__m128i*>(ctx[i]->memory), reinterpret_cast<__m128i*>(ctx[i]->state));
+        xmrig::keccakf(reinterpret_cast<uint64_t*>(ctx[i]->state), 24);
+        extra_hashes[ctx[i]->state[0] & 3](ctx[i]->state, 200, output + 32 * i);
+    }
+}
+
+
+/*
+ * Generic N-way kernel for the small scratchpad algorithms (cn-lite, cn-pico), used for 8 and 16 ways.
+ * Lane state lives in arrays and every step loops over the lanes, so all loads of one step are in flight together.
+ */
+template<xmrig::Algo ALGO, bool SOFT_AES, xmrig::Variant VARIANT, size_t N>
+inline void cryptonight_multi_hash(const uint8_t *__restrict__ input, size_t size, uint8_t *__restrict__ output, cryptonight_ctx **__restrict__ ctx, uint64_t height)
+{
+    constexpr size_t MASK         = xmrig::cn_select_mask<ALGO>();
+    constexpr size_t ITERATIONS   = xmrig::cn_select_iter<ALGO, VARIANT>();
+    constexpr size_t MEM          = xmrig::cn_select_memory<ALGO>();
+    constexpr xmrig::Variant BASE = xmrig::cn_base_variant<VARIANT>();
+
+    static_assert(ALGO != xmrig::CRYPTONIGHT_HEAVY && VARIANT != xmrig::VARIANT_GPU && !xmrig::cn_is_cryptonight_r<VARIANT>(), "unsupported algorithm/variant");
+
+    if (BASE == xmrig::VARIANT_1 && size < 43) {
+        memset(output, 0, 32 * N);
+        return;
+    }
+
+    for (size_t i = 0; i < N; i++) {
+        xmrig::keccak(input + size * i, size, ctx[i]->state);
+    }
+
+    cn_explode_scratchpads<ALGO, MEM, SOFT_AES, N>(ctx);
+
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
+    uint8_t *l[N];
+    __m128i *ptr[N];
+    __m128i ax[N], bx0[N], bx1[N], cx[N], mc[N];
+    __m128i division_result_xmm[N], sqrt_result_xmm[N];
+    uint64_t idx[N], cl[N], ch[N];
+
+    for (size_t k = 0; k < N; k++) {
+        const uint64_t *h = reinterpret_cast<const uint64_t*>(ctx[k]->state);
+
+        l[k]   = ctx[k]->memory;
+        ax[k]  = _mm_set_epi64x(h[1] ^ h[5], h[0] ^ h[4]);
+        bx0[k] = _mm_set_epi64x(h[3] ^ h[7], h[2] ^ h[6]);
+        bx1[k] = _mm_set_epi64x(h[9] ^ h[11], h[8] ^ h[10]);
+        mc[k]  = _mm_setzero_si128();
+        idx[k] = h[0] ^ h[4];
+
+        if (BASE == xmrig::VARIANT_1) {
+            mc[k] = _mm_set_epi64x(cn_load64(input + k * size + 35, 0) ^ h[24], 0);
+        }
+
+        division_result_xmm[k] = _mm_cvtsi64_si128(h[12]);
+        sqrt_result_xmm[k]     = _mm_cvtsi64_si128(h[13]);
+    }
+
+    VARIANT2_SET_ROUNDING_MODE();
+
+    for (size_t i = 0; i < ITERATIONS; i++) {
+        if (cn_aborted(ctx[0], i)) {
+            return;
+        }
+
+        for (size_t k = 0; k < N; k++) {
+            ptr[k] = reinterpret_cast<__m128i*>(&l[k][idx[k] & MASK]);
+            cx[k]  = _mm_load_si128(ptr[k]);
+        }
+
+        for (size_t k = 0; k < N; k++) {
+            if (SOFT_AES) {
+                cx[k] = soft_aesenc(&cx[k], ax[k], (const uint32_t*)saes_table);
+            } else {
+                cx[k] = _mm_aesenc_si128(cx[k], ax[k]);
+            }
+
+            if (BASE == xmrig::VARIANT_1 || BASE == xmrig::VARIANT_2) {
+                cryptonight_monero_tweak<VARIANT, BASE>((uint64_t*)ptr[k], l[k], idx[k] & MASK, ax[k], bx0[k], bx1[k], cx[k]);
+            } else {
+                _mm_store_si128(ptr[k], vec_xor(bx0[k], cx[k]));
+            }
+        }
+
+        for (size_t k = 0; k < N; k++) {
+            idx[k] = _mm_cvtsi128_si64(cx[k]);
+            ptr[k] = reinterpret_cast<__m128i*>(&l[k][idx[k] & MASK]);
+            cl[k]  = cn_load64(ptr[k], 0);
+            ch[k]  = cn_load64(ptr[k], 1);
+        }
+
+        for (size_t k = 0; k < N; k++) {
+            uint64_t hi, lo;
+
+            if (BASE == xmrig::VARIANT_2) {
+                __m128i &division_result_xmm_lane = division_result_xmm[k];
+                __m128i &sqrt_result_xmm_lane     = sqrt_result_xmm[k];
+
+                VARIANT2_INTEGER_MATH(lane, cl[k], cx[k]);
+            }
+
+            lo = __umul128(idx[k], cl[k], &hi);
+
+            if (BASE == xmrig::VARIANT_2) {
+                VARIANT2_SHUFFLE2(l[k], idx[k] & MASK, ax[k], bx0[k], bx1[k], hi, lo, (VARIANT == xmrig::VARIANT_RWZ ? 1 : 0));
+            }
+
+            ax[k] = _mm_add_epi64(ax[k], _mm_set_epi64x(lo, hi));
+
+            if (BASE == xmrig::VARIANT_1) {
+                _mm_store_si128(ptr[k], vec_xor(ax[k], mc[k]));
+
+                if (VARIANT == xmrig::VARIANT_RTO) {
+                    cn_store64(ptr[k], 1, cn_load64(ptr[k], 1) ^ cn_load64(ptr[k], 0));
+                }
+            } else {
+                _mm_store_si128(ptr[k], ax[k]);
+            }
+
+            ax[k]  = vec_xor(ax[k], _mm_set_epi64x(ch[k], cl[k]));
+            idx[k] = _mm_cvtsi128_si64(ax[k]);
+
+            if (BASE == xmrig::VARIANT_2) {
+                bx1[k] = bx0[k];
+            }
+
+            bx0[k] = cx[k];
+        }
+    }
+
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
+    cn_implode_scratchpads<ALGO, MEM, SOFT_AES, N>(ctx);
+
+    for (size_t i = 0; i < N; i++) {
         xmrig::keccakf(reinterpret_cast<uint64_t*>(ctx[i]->state), 24);
         extra_hashes[ctx[i]->state[0] & 3](ctx[i]->state, 200, output + 32 * i);
     }
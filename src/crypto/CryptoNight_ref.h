@@ -0,0 +1,590 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2019 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2018      Lee Clagett <https://github.com/vtnerd>
+ * Copyright 2018-2019 SChernykh   <https://github.com/SChernykh>
+ * Copyright 2016-2019 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef XMRIG_CRYPTONIGHT_REF_H
+#define XMRIG_CRYPTONIGHT_REF_H
+
+
+/*
+ * Portable scalar CryptoNight kernels.
+ *
+ * No SIMD intrinsics are used: 128-bit values are kept as two little-endian
+ * 64-bit words, AES is done with the soft AES tables and every access to the
+ * scratchpad or the state copies words in and out with memcpy. The code follows
+ * the x86 kernels step by step and is meant as the ground truth to diff the
+ * optimized backends against, not for mining speed.
+ *
+ * The kernels are built into every backend and selected with --av=15 (AV_REF),
+ * so both sides of a comparison run in the same binary. With CPU_BACKEND=ref
+ * they are also the whole backend: the func_table wrappers at the end accept
+ * SOFT_AES and ignore it, multiway kernels hash each way in turn.
+ */
+
+
+#include <fenv.h>
+#include <math.h>
+#include <string.h>
+
+
+#include "common/crypto/keccak.h"
+#include "crypto/CryptoNight.h"
+#include "crypto/CryptoNight_constants.h"
+#include "crypto/CryptoNight_monero.h"
+#include "crypto/soft_aes_tables.h"
+
+
+extern "C"
+{
+#include "crypto/c_groestl.h"
+#include "crypto/c_blake256.h"
+#include "crypto/c_jh.h"
+#include "crypto/c_skein.h"
+}
+
+
+static inline void ref_blake_hash(const uint8_t *input, size_t len, uint8_t *output) {
+    blake256_hash(output, input, len);
+}
+
+
+static inline void ref_groestl_hash(const uint8_t *input, size_t len, uint8_t *output) {
+    groestl(input, len * 8, output);
+}
+
+
+static inline void ref_jh_hash(const uint8_t *input, size_t len, uint8_t *output) {
+    jh_hash(32 * 8, input, 8 * len, output);
+}
+
+
+static inline void ref_skein_hash(const uint8_t *input, size_t len, uint8_t *output) {
+    xmr_skein(input, output);
+}
+
+
+static void (* const ref_extra_hashes[4])(const uint8_t *, size_t, uint8_t *) = {ref_blake_hash, ref_groestl_hash, ref_jh_hash, ref_skein_hash};
+
+
+static inline uint64_t ref_umul128(uint64_t multiplier, uint64_t multiplicand, uint64_t *product_hi)
+{
+#   ifdef __SIZEOF_INT128__
+    const unsigned __int128 r = (unsigned __int128) multiplier * (unsigned __int128) multiplicand;
+    *product_hi = r >> 64;
+    return (uint64_t) r;
+#   else
+    const uint64_t a = multiplier >> 32;
+    const uint64_t b = multiplier & 0xFFFFFFFF;
+    const uint64_t c = multiplicand >> 32;
+    const uint64_t d = multiplicand & 0xFFFFFFFF;
+
+    const uint64_t ad = a * d;
+    const uint64_t bd = b * d;
+
+    const uint64_t adbc       = ad + (b * c);
+    const uint64_t adbc_carry = adbc < ad ? 1 : 0;
+
+    const uint64_t product_lo       = bd + (adbc << 32);
+    const uint64_t product_lo_carry = product_lo < bd ? 1 : 0;
+    *product_hi = (a * c) + (adbc >> 32) + (adbc_carry << 32) + product_lo_carry;
+
+    return product_lo;
+#   endif
+}
+
+
+static inline uint32_t ref_sub_word(uint32_t w)
+{
+    return (static_cast<uint32_t>(saes_sbox[w >> 24]) << 24) |
+           (static_cast<uint32_t>(saes_sbox[(w >> 16) & 0xff]) << 16) |
+           (static_cast<uint32_t>(saes_sbox[(w >> 8) & 0xff]) << 8) |
+            static_cast<uint32_t>(saes_sbox[w & 0xff]);
+}
+
+
+static inline uint32_t ref_rotr32(uint32_t value, uint32_t amount)
+{
+    return (value >> amount) | (value << ((32 - amount) & 31));
+}
+
+
+/* AES-256 key schedule truncated to the 10 round keys used by CryptoNight. */
+static inline void ref_aes_genkey(const uint8_t *memory, uint32_t (&k)[40])
+{
+    memcpy(k, memory, 32);
+
+    uint32_t rcon = 1;
+    for (size_t i = 8; i < 40; ++i) {
+        uint32_t t = k[i - 1];
+
+        if ((i & 7) == 0) {
+            t     = ref_rotr32(ref_sub_word(t), 8) ^ rcon;
+            rcon <<= 1;
+        }
+        else if ((i & 7) == 4) {
+            t = ref_sub_word(t);
+        }
+
+        k[i] = k[i - 8] ^ t;
+    }
+}
+
+
+static inline void ref_aesenc(uint32_t *x, const uint32_t *key)
+{
+    const uint32_t x0 = x[0];
+    const uint32_t x1 = x[1];
+    const uint32_t x2 = x[2];
+    const uint32_t x3 = x[3];
+
+    x[0] = saes_table[0][x0 & 0xff] ^ saes_table[1][(x1 >> 8) & 0xff] ^ saes_table[2][(x2 >> 16) & 0xff] ^ saes_table[3][x3 >> 24] ^ key[0];
+    x[1] = saes_table[0][x1 & 0xff] ^ saes_table[1][(x2 >> 8) & 0xff] ^ saes_table[2][(x3 >> 16) & 0xff] ^ saes_table[3][x0 >> 24] ^ key[1];
+    x[2] = saes_table[0][x2 & 0xff] ^ saes_table[1][(x3 >> 8) & 0xff] ^ saes_table[2][(x0 >> 16) & 0xff] ^ saes_table[3][x1 >> 24] ^ key[2];
+    x[3] = saes_table[0][x3 & 0xff] ^ saes_table[1][(x0 >> 8) & 0xff] ^ saes_table[2][(x1 >> 16) & 0xff] ^ saes_table[3][x2 >> 24] ^ key[3];
+}
+
+
+static inline void ref_aes_rounds(const uint32_t (&k)[40], uint32_t (&x)[8][4])
+{
+    for (size_t r = 0; r < 10; ++r) {
+        for (size_t j = 0; j < 8; ++j) {
+            ref_aesenc(x[j], k + r * 4);
+        }
+    }
+}
+
+
+static inline void ref_mix_and_propagate(uint32_t (&x)[8][4])
+{
+    uint32_t tmp0[4];
+    memcpy(tmp0, x[0], sizeof(tmp0));
+
+    for (size_t j = 0; j < 7; ++j) {
+        for (size_t w = 0; w < 4; ++w) {
+            x[j][w] ^= x[j + 1][w];
+        }
+    }
+
+    for (size_t w = 0; w < 4; ++w) {
+        x[7][w] ^= tmp0[w];
+    }
+}
+
+
+template<xmrig::Algo ALGO, size_t MEM>
+static inline void ref_explode_scratchpad(const uint8_t *input, uint8_t *output)
+{
+    uint32_t k[40];
+    uint32_t x[8][4];
+
+    ref_aes_genkey(input, k);
+    memcpy(x, input + 64, sizeof(x));
+
+    if (ALGO == xmrig::CRYPTONIGHT_HEAVY) {
+        for (size_t i = 0; i < 16; i++) {
+            ref_aes_rounds(k, x);
+            ref_mix_and_propagate(x);
+        }
+    }
+
+    for (size_t i = 0; i < MEM; i += sizeof(x)) {
+        ref_aes_rounds(k, x);
+        memcpy(output + i, x, sizeof(x));
+    }
+}
+
+
+template<xmrig::Algo ALGO, size_t MEM>
+static inline void ref_implode_scratchpad(const uint8_t *input, uint8_t *output)
+{
+    uint32_t k[40];
+    uint32_t x[8][4];
+
+    ref_aes_genkey(output + 32, k);
+    memcpy(x, output + 64, sizeof(x));
+
+    const size_t passes = ALGO == xmrig::CRYPTONIGHT_HEAVY ? 2 : 1;
+
+    for (size_t pass = 0; pass < passes; ++pass) {
+        for (size_t i = 0; i < MEM; i += sizeof(x)) {
+            uint32_t in[8][4];
+            memcpy(in, input + i, sizeof(in));
+
+            for (size_t w = 0; w < 32; ++w) {
+                x[w / 4][w % 4] ^= in[w / 4][w % 4];
+            }
+
+            ref_aes_rounds(k, x);
+
+            if (ALGO == xmrig::CRYPTONIGHT_HEAVY) {
+                ref_mix_and_propagate(x);
+            }
+        }
+    }
+
+    if (ALGO == xmrig::CRYPTONIGHT_HEAVY) {
+        for (size_t i = 0; i < 16; i++) {
+            ref_aes_rounds(k, x);
+            ref_mix_and_propagate(x);
+        }
+    }
+
+    memcpy(output + 64, x, sizeof(x));
+}
+
+
+static inline void ref_aes_round_tweak_div(uint64_t *c, const uint64_t *key)
+{
+    uint32_t k[4];
+    uint32_t x[4];
+    uint64_t in[2] = { ~c[0], ~c[1] };
+
+    memcpy(k, key, sizeof(k));
+    memcpy(x, in, sizeof(x));
+
+    #define BYTE(p, i) ((unsigned char*)&x[p])[i]
+    k[0] ^= saes_table[0][BYTE(0, 0)] ^ saes_table[1][BYTE(1, 1)] ^ saes_table[2][BYTE(2, 2)] ^ saes_table[3][BYTE(3, 3)];
+    x[0] ^= k[0];
+    k[1] ^= saes_table[0][BYTE(1, 0)] ^ saes_table[1][BYTE(2, 1)] ^ saes_table[2][BYTE(3, 2)] ^ saes_table[3][BYTE(0, 3)];
+    x[1] ^= k[1];
+    k[2] ^= saes_table[0][BYTE(2, 0)] ^ saes_table[1][BYTE(3, 1)] ^ saes_table[2][BYTE(0, 2)] ^ saes_table[3][BYTE(1, 3)];
+    x[2] ^= k[2];
+    k[3] ^= saes_table[0][BYTE(3, 0)] ^ saes_table[1][BYTE(0, 1)] ^ saes_table[2][BYTE(1, 2)] ^ saes_table[3][BYTE(2, 3)];
+    #undef BYTE
+
+    memcpy(c, k, sizeof(k));
+}
+
+
+static inline uint64_t ref_int_sqrt_v2(const uint64_t n0)
+{
+    double x;
+    uint64_t r = (n0 >> 12) + (1023ULL << 52);
+
+    memcpy(&x, &r, sizeof(x));
+    x = sqrt(x);
+    memcpy(&r, &x, sizeof(r));
+
+    const uint64_t s = r >> 20;
+    r >>= 19;
+
+    const uint64_t x2 = (s - (1022ULL << 32)) * (r - s - (1022ULL << 32) + 1);
+    if (x2 < n0) {
+        ++r;
+    }
+
+    return r;
+}
+
+
+template<xmrig::Variant VARIANT>
+static inline void ref_shuffle(uint8_t *l, uint64_t offset, const uint64_t *a, const uint64_t *b, const uint64_t *b1, uint64_t *c, bool reverse)
+{
+    uint8_t *p1 = l + (offset ^ 0x10);
+    uint8_t *p2 = l + (offset ^ 0x20);
+    uint8_t *p3 = l + (offset ^ 0x30);
+
+    const uint8_t *src1 = reverse ? p3 : p1;
+    const uint8_t *src3 = reverse ? p1 : p3;
+
+    const uint64_t chunk1[2] = { cn_load64(src1, 0), cn_load64(src1, 1) };
+    const uint64_t chunk2[2] = { cn_load64(p2, 0),   cn_load64(p2, 1) };
+    const uint64_t chunk3[2] = { cn_load64(src3, 0), cn_load64(src3, 1) };
+
+    cn_store64(p1, 0, chunk3[0] + b1[0]); cn_store64(p1, 1, chunk3[1] + b1[1]);
+    cn_store64(p2, 0, chunk1[0] + b[0]);  cn_store64(p2, 1, chunk1[1] + b[1]);
+    cn_store64(p3, 0, chunk2[0] + a[0]);  cn_store64(p3, 1, chunk2[1] + a[1]);
+
+    if (VARIANT == xmrig::VARIANT_4) {
+        c[0] ^= chunk1[0] ^ chunk2[0] ^ chunk3[0];
+        c[1] ^= chunk1[1] ^ chunk2[1] ^ chunk3[1];
+    }
+}
+
+
+static inline void ref_shuffle2(uint8_t *l, uint64_t offset, const uint64_t *a, const uint64_t *b, const uint64_t *b1, uint64_t &hi, uint64_t &lo, bool reverse)
+{
+    uint8_t *p1 = l + (offset ^ 0x10);
+    uint8_t *p2 = l + (offset ^ 0x20);
+    uint8_t *p3 = l + (offset ^ 0x30);
+
+    const uint64_t chunk1[2] = { cn_load64(p1, 0) ^ hi, cn_load64(p1, 1) ^ lo };
+    const uint64_t chunk2[2] = { cn_load64(p2, 0), cn_load64(p2, 1) };
+    const uint64_t chunk3[2] = { cn_load64(p3, 0), cn_load64(p3, 1) };
+
+    hi ^= chunk2[0];
+    lo ^= chunk2[1];
+
+    if (reverse) {
+        cn_store64(p1, 0, chunk1[0] + b1[0]); cn_store64(p1, 1, chunk1[1] + b1[1]);
+        cn_store64(p2, 0, chunk3[0] + b[0]);  cn_store64(p2, 1, chunk3[1] + b[1]);
+    } else {
+        cn_store64(p1, 0, chunk3[0] + b1[0]); cn_store64(p1, 1, chunk3[1] + b1[1]);
+        cn_store64(p2, 0, chunk1[0] + b[0]);  cn_store64(p2, 1, chunk1[1] + b[1]);
+    }
+
+    cn_store64(p3, 0, chunk2[0] + a[0]); cn_store64(p3, 1, chunk2[1] + a[1]);
+}
+
+
+template<xmrig::Algo ALGO, xmrig::Variant VARIANT>
+static void cryptonight_ref_hash(const uint8_t *input, size_t size, uint8_t *output, cryptonight_ctx *ctx, uint64_t height)
+{
+    constexpr size_t MASK         = xmrig::cn_select_mask<ALGO>();
+    constexpr size_t ITERATIONS   = xmrig::cn_select_iter<ALGO, VARIANT>();
+    constexpr size_t MEM          = xmrig::cn_select_memory<ALGO>();
+    constexpr xmrig::Variant BASE = xmrig::cn_base_variant<VARIANT>();
+    constexpr bool REVERSE        = VARIANT == xmrig::VARIANT_RWZ;
+
+    static_assert(MASK > 0 && ITERATIONS > 0 && MEM > 0, "unsupported algorithm/variant");
+
+    if (BASE == xmrig::VARIANT_1 && size < 43) {
+        memset(output, 0, 32);
+        return;
+    }
+
+    xmrig::keccak(input, size, ctx->state);
+    ref_explode_scratchpad<ALGO, MEM>(ctx->state, ctx->memory);
+
+    if (cn_aborted(ctx)) {
+        return;
+    }
+
+    uint64_t h[25];
+    memcpy(h, ctx->state, sizeof(h));
+
+    uint8_t *l = ctx->memory;
+
+    uint64_t tweak1_2 = 0;
+    if (BASE == xmrig::VARIANT_1) {
+        tweak1_2 = cn_load64(input + 35, 0) ^ h[24];
+    }
+
+    uint64_t division_result = h[12];
+    uint64_t sqrt_result     = h[13];
+    if (BASE == xmrig::VARIANT_2) {
+        fesetround(FE_DOWNWARD);
+    }
+
+    uint32_t r[9];
+    V4_Instruction code[256];
+    if (xmrig::cn_is_cryptonight_r<VARIANT>()) {
+        r[0] = static_cast<uint32_t>(h[12]);
+        r[1] = static_cast<uint32_t>(h[12] >> 32);
+        r[2] = static_cast<uint32_t>(h[13]);
+        r[3] = static_cast<uint32_t>(h[13] >> 32);
+
+        v4_random_math_init<VARIANT>(code, height);
+    }
+
+    uint64_t a[2]  = { h[0] ^ h[4], h[1] ^ h[5] };
+    uint64_t b0[2] = { h[2] ^ h[6], h[3] ^ h[7] };
+    uint64_t b1[2] = { h[8] ^ h[10], h[9] ^ h[11] };
+
+    uint64_t idx = a[0];
+
+    for (size_t i = 0; i < ITERATIONS; i++) {
+        if (cn_aborted(ctx, i)) {
+            return;
+        }
+
+        uint8_t *p = l + (idx & MASK);
+        uint64_t c[2] = { cn_load64(p, 0), cn_load64(p, 1) };
+        const uint64_t ax[2] = { a[0], a[1] };
+
+        if (VARIANT == xmrig::VARIANT_TUBE) {
+            ref_aes_round_tweak_div(c, ax);
+        }
+        else {
+            uint32_t x[4];
+            uint32_t key[4];
+            memcpy(x, c, sizeof(x));
+            memcpy(key, ax, sizeof(key));
+            ref_aesenc(x, key);
+            memcpy(c, x, sizeof(x));
+        }
+
+        if (BASE == xmrig::VARIANT_2) {
+            ref_shuffle<VARIANT>(l, idx & MASK, ax, b0, b1, c, REVERSE);
+        }
+
+        uint64_t vh = b0[1] ^ c[1];
+
+        if (BASE == xmrig::VARIANT_1) {
+            const uint8_t x = static_cast<uint8_t>(vh >> 24);
+            static const uint16_t table = 0x7531;
+            const uint8_t index = (((x >> (VARIANT == xmrig::VARIANT_XTL ? 4 : 3)) & 6) | (x & 1)) << 1;
+            vh ^= static_cast<uint64_t>((table >> index) & 0x3) << 28;
+        }
+
+        cn_store64(p, 0, b0[0] ^ c[0]);
+        cn_store64(p, 1, vh);
+
+        idx = c[0];
+        p   = l + (idx & MASK);
+
+        uint64_t hi, lo;
+        uint64_t cl = cn_load64(p, 0);
+        uint64_t ch = cn_load64(p, 1);
+
+        if (BASE == xmrig::VARIANT_2) {
+            if (xmrig::cn_is_cryptonight_r<VARIANT>()) {
+                cl ^= (r[0] + r[1]) | (static_cast<uint64_t>(r[2] + r[3]) << 32);
+                r[4] = static_cast<uint32_t>(a[0]);
+                r[5] = static_cast<uint32_t>(a[1]);
+                r[6] = static_cast<uint32_t>(b0[0]);
+                r[7] = static_cast<uint32_t>(b1[0]);
+                r[8] = static_cast<uint32_t>(b1[1]);
+
+                v4_random_math(code, r);
+
+                if (VARIANT == xmrig::VARIANT_4) {
+                    a[0] ^= r[2] | (static_cast<uint64_t>(r[3]) << 32);
+                    a[1] ^= r[0] | (static_cast<uint64_t>(r[1]) << 32);
+                }
+            } else {
+                cl ^= division_result ^ (sqrt_result << 32);
+                const uint32_t d = static_cast<uint32_t>(c[0] + (sqrt_result << 1)) | 0x80000001UL;
+                division_result  = static_cast<uint32_t>(c[1] / d) + ((c[1] % d) << 32);
+                sqrt_result      = ref_int_sqrt_v2(c[0] + division_result);
+            }
+        }
+
+        lo = ref_umul128(idx, cl, &hi);
+
+        if (BASE == xmrig::VARIANT_2) {
+            if (VARIANT == xmrig::VARIANT_4) {
+                ref_shuffle<VARIANT>(l, idx & MASK, ax, b0, b1, c, false);
+            } else {
+                ref_shuffle2(l, idx & MASK, ax, b0, b1, hi, lo, REVERSE);
+            }
+        }
+
+        a[0] += hi;
+        a[1] += lo;
+
+        cn_store64(p, 0, a[0]);
+
+        if (BASE == xmrig::VARIANT_1 && (VARIANT == xmrig::VARIANT_TUBE || VARIANT == xmrig::VARIANT_RTO)) {
+            cn_store64(p, 1, a[1] ^ tweak1_2 ^ a[0]);
+        } else if (BASE == xmrig::VARIANT_1) {
+            cn_store64(p, 1, a[1] ^ tweak1_2);
+        } else {
+            cn_store64(p, 1, a[1]);
+        }
+
+        a[0] ^= cl;
+        a[1] ^= ch;
+        idx = a[0];
+
+        if (ALGO == xmrig::CRYPTONIGHT_HEAVY) {
+            p = l + (idx & MASK);
+
+            int64_t n = static_cast<int64_t>(cn_load64(p, 0));
+            int32_t d = static_cast<int32_t>(cn_load32(p, 2));
+            int64_t q = n / (d | 0x5);
+
+            cn_store64(p, 0, n ^ q);
+
+            if (VARIANT == xmrig::VARIANT_XHV) {
+                d = ~d;
+            }
+
+            idx = d ^ q;
+        }
+
+        if (BASE == xmrig::VARIANT_2) {
+            b1[0] = b0[0];
+            b1[1] = b0[1];
+        }
+
+        b0[0] = c[0];
+        b0[1] = c[1];
+    }
+
+    if (cn_aborted(ctx)) {
+        return;
+    }
+
+    ref_implode_scratchpad<ALGO, MEM>(ctx->memory, ctx->state);
+
+    memcpy(h, ctx->state, sizeof(h));
+    xmrig::keccakf(h, 24);
+    memcpy(ctx->state, h, sizeof(h));
+
+    ref_extra_hashes[ctx->state[0] & 3](ctx->state, 200, output);
+}
+
+
+template<xmrig::Algo ALGO, xmrig::Variant VARIANT, size_t N>
+inline void cryptonight_ref_multi_hash(const uint8_t *__restrict__ input, size_t size, uint8_t *__restrict__ output, cryptonight_ctx **__restrict__ ctx, uint64_t height)
+{
+    for (size_t i = 0; i < N; ++i) {
+        cryptonight_ref_hash<ALGO, VARIANT>(input + i * size, size, output + i * 32, ctx[i], height);
+
+        if (cn_aborted(ctx[i])) {
+            return;
+        }
+    }
+}
+
+
+#ifdef XMRIG_REF
+template<xmrig::Algo ALGO, bool SOFT_AES, xmrig::Variant VARIANT>
+inline void cryptonight_single_hash(const uint8_t *__restrict__ input, size_t size, uint8_t *__restrict__ output, cryptonight_ctx **__restrict__ ctx, uint64_t height)
+{
+    cryptonight_ref_multi_hash<ALGO, VARIANT, 1>(input, size, output, ctx, height);
+}
+
+
+template<xmrig::Algo ALGO, bool SOFT_AES, xmrig::Variant VARIANT>
+inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t size, uint8_t *__restrict__ output, cryptonight_ctx **__restrict__ ctx, uint64_t height)
+{
+    cryptonight_ref_multi_hash<ALGO, VARIANT, 2>(input, size, output, ctx, height);
+}
+
+
+template<xmrig::Algo ALGO, bool SOFT_AES, xmrig::Variant VARIANT>
+inline void cryptonight_triple_hash(const uint8_t *__restrict__ input, size_t size, uint8_t *__restrict__ output, cryptonight_ctx **__restrict__ ctx, uint64_t height)
+{
+    cryptonight_ref_multi_hash<ALGO, VARIANT, 3>(input, size, output, ctx, height);
+}
+
+
+template<xmrig::Algo ALGO, bool SOFT_AES, xmrig::Variant VARIANT>
+inline void cryptonight_quad_hash(const uint8_t *__restrict__ input, size_t size, uint8_t *__restrict__ output, cryptonight_ctx **__restrict__ ctx, uint64_t height)
+{
+    cryptonight_ref_multi_hash<ALGO, VARIANT, 4>(input, size, output, ctx, height);
+}
+
+
+template<xmrig::Algo ALGO, bool SOFT_AES, xmrig::Variant VARIANT>
+inline void cryptonight_penta_hash(const uint8_t *__restrict__ input, size_t size, uint8_t *__restrict__ output, cryptonight_ctx **__restrict__ ctx, uint64_t height)
+{
+    cryptonight_ref_multi_hash<ALGO, VARIANT, 5>(input, size, output, ctx, height);
+}
+#endif
+
+
+#endif /* XMRIG_CRYPTONIGHT_REF_H */
@@ -37,6 +37,7 @@
 
 #include "common/cpu/Cpu.h"
 #include "common/crypto/keccak.h"
+#include "crypto/CnRCache.h"
 #include "crypto/CryptoNight.h"
 #include "crypto/CryptoNight_constants.h"
 #include "crypto/CryptoNight_monero.h"
@@ -194,10 +195,13 @@ static inline void aes_genkey(const __m128i* memory, __m128i* k0, __m128i* k1, _
 
 static FORCEINLINE void soft_aesenc(void* __restrict ptr, const void* __restrict key, const uint32_t* __restrict t)
 {
-    uint32_t x0 = ((const uint32_t*)(ptr))[0];
-    uint32_t x1 = ((const uint32_t*)(ptr))[1];
-    uint32_t x2 = ((const uint32_t*)(ptr))[2];
-    uint32_t x3 = ((const uint32_t*)(ptr))[3];
+    uint32_t x[4];
+    memcpy(x, ptr, sizeof(x));
+
+    uint32_t x0 = x[0];
+    uint32_t x1 = x[1];
+    uint32_t x2 = x[2];
+    uint32_t x3 = x[3];
 
     uint32_t y0 = t[x0 & 0xff]; x0 >>= 8;
     uint32_t y1 = t[x1 & 0xff]; x1 >>= 8;
@@ -222,18 +226,25 @@ static FORCEINLINE void soft_aesenc(void* __restrict ptr, const void* __restrict
     y2 ^= t[x1];
     y3 ^= t[x2];
 
-    ((uint32_t*)ptr)[0] = y0 ^ ((uint32_t*)key)[0];
-    ((uint32_t*)ptr)[1] = y1 ^ ((uint32_t*)key)[1];
-    ((uint32_t*)ptr)[2] = y2 ^ ((uint32_t*)key)[2];
-    ((uint32_t*)ptr)[3] = y3 ^ ((uint32_t*)key)[3];
+    uint32_t k[4];
+    memcpy(k, key, sizeof(k));
+
+    x[0] = y0 ^ k[0];
+    x[1] = y1 ^ k[1];
+    x[2] = y2 ^ k[2];
+    x[3] = y3 ^ k[3];
+    memcpy(ptr, x, sizeof(x));
 }
 
 static FORCEINLINE __m128i soft_aesenc(const void* __restrict ptr, const __m128i key, const uint32_t* __restrict t)
 {
-    uint32_t x0 = ((const uint32_t*)(ptr))[0];
-    uint32_t x1 = ((const uint32_t*)(ptr))[1];
-    uint32_t x2 = ((const uint32_t*)(ptr))[2];
-    uint32_t x3 = ((const uint32_t*)(ptr))[3];
+    uint32_t x[4];
+    memcpy(x, ptr, sizeof(x));
+
+    uint32_t x0 = x[0];
+    uint32_t x1 = x[1];
+    uint32_t x2 = x[2];
+    uint32_t x3 = x[3];
 
     uint32_t y0 = t[x0 & 0xff]; x0 >>= 8;
     uint32_t y1 = t[x1 & 0xff]; x1 >>= 8;
@@ -485,6 +496,138 @@ static inline void cn_implode_scratchpad(const __m128i *input, __m128i *output)
 }
 
 
+template<bool SOFT_AES>
+static inline void aes_10_rounds(const __m128i *k, __m128i *x)
+{
+    for (size_t r = 0; r < 10; r++) {
+        aes_round<SOFT_AES>(k[r], &x[0], &x[1], &x[2], &x[3], &x[4], &x[5], &x[6], &x[7]);
+    }
+}
+
+
+/*
+ * Resumable versions of cn_explode_scratchpad() and cn_implode_scratchpad(), step() processes one 128 byte block.
+ * Used by the pipelined kernel to spread the scratchpad passes of the neighbouring hashes over the main loop.
+ */
+template<xmrig::Algo ALGO, size_t MEM, bool SOFT_AES>
+struct cn_explode_pass
+{
+    inline cn_explode_pass() : k(), x(), out(nullptr), pos(MEM / sizeof(__m128i)) {}
+
+    inline void begin(const __m128i *input, __m128i *output)
+    {
+        aes_genkey<SOFT_AES>(input, &k[0], &k[1], &k[2], &k[3], &k[4], &k[5], &k[6], &k[7], &k[8], &k[9]);
+
+        for (size_t j = 0; j < 8; j++) {
+            x[j] = _mm_load_si128(input + 4 + j);
+        }
+
+        if (ALGO == xmrig::CRYPTONIGHT_HEAVY) {
+            for (size_t i = 0; i < 16; i++) {
+                aes_10_rounds<SOFT_AES>(k, x);
+                mix_and_propagate(x[0], x[1], x[2], x[3], x[4], x[5], x[6], x[7]);
+            }
+        }
+
+        out = output;
+        pos = 0;
+    }
+
+    inline void step()
+    {
+        if (pos >= MEM / sizeof(__m128i)) {
+            return;
+        }
+
+        aes_10_rounds<SOFT_AES>(k, x);
+
+        for (size_t j = 0; j < 8; j++) {
+            _mm_store_si128(out + pos + j, x[j]);
+        }
+
+        pos += 8;
+    }
+
+    inline void finish()
+    {
+        while (pos < MEM / sizeof(__m128i)) {
+            step();
+        }
+    }
+
+    __m128i k[10];
+    __m128i x[8];
+    __m128i *out;
+    size_t pos;
+};
+
+
+template<xmrig::Algo ALGO, size_t MEM, bool SOFT_AES>
+struct cn_implode_pass
+{
+    static constexpr size_t BLOCKS = (ALGO == xmrig::CRYPTONIGHT_HEAVY ? 2 : 1) * MEM / (sizeof(__m128i) * 8);
+
+    inline cn_implode_pass() : k(), x(), in(nullptr), out(nullptr), pos(BLOCKS * 8) {}
+
+    inline void begin(const __m128i *input, __m128i *output)
+    {
+        aes_genkey<SOFT_AES>(output + 2, &k[0], &k[1], &k[2], &k[3], &k[4], &k[5], &k[6], &k[7], &k[8], &k[9]);
+
+        for (size_t j = 0; j < 8; j++) {
+            x[j] = _mm_load_si128(output + 4 + j);
+        }
+
+        in  = input;
+        out = output;
+        pos = 0;
+    }
+
+    inline void step()
+    {
+        if (pos >= BLOCKS * 8) {
+            return;
+        }
+
+        const __m128i *block = in + (pos & (MEM / sizeof(__m128i) - 1));
+        for (size_t j = 0; j < 8; j++) {
+            x[j] = _mm_xor_si128(_mm_load_si128(block + j), x[j]);
+        }
+
+        aes_10_rounds<SOFT_AES>(k, x);
+
+        if (ALGO == xmrig::CRYPTONIGHT_HEAVY) {
+            mix_and_propagate(x[0], x[1], x[2], x[3], x[4], x[5], x[6], x[7]);
+        }
+
+        pos += 8;
+    }
+
+    inline void finish()
+    {
+        while (pos < BLOCKS * 8) {
+            step();
+        }
+
+        if (ALGO == xmrig::CRYPTONIGHT_HEAVY) {
+            for (size_t i = 0; i < 16; i++) {
+                aes_10_rounds<SOFT_AES>(k, x);
+                mix_and_propagate(x[0], x[1], x[2], x[3], x[4], x[5], x[6], x[7]);
+            }
+        }
+
+        for (size_t j = 0; j < 8; j++) {
+            _mm_store_si128(out + 4 + j, x[j]);
+        }
+    }
+
+    __m128i k[10];
+    __m128i x[8];
+    const __m128i *in;
+    __m128i *out;
+    size_t pos;
+};
+
+
 static inline __m128i aes_round_tweak_div(const __m128i &in, const __m128i &key)
 {
     alignas(16) uint32_t k[4];
@@ -535,7 +678,7 @@ static inline void cryptonight_monero_tweak(uint64_t* mem_out, const uint8_t* l,
         _mm_store_si128((__m128i *)mem_out, _mm_xor_si128(bx0, cx));
     } else {
         __m128i tmp = _mm_xor_si128(bx0, cx);
-        mem_out[0] = _mm_cvtsi128_si64(tmp);
+        cn_store64(mem_out, 0, _mm_cvtsi128_si64(tmp));
 
         tmp = _mm_castps_si128(_mm_movehl_ps(_mm_castsi128_ps(tmp), _mm_castsi128_ps(tmp)));
         uint64_t vh = _mm_cvtsi128_si64(tmp);
@@ -545,56 +688,28 @@ static inline void cryptonight_monero_tweak(uint64_t* mem_out, const uint8_t* l,
         const uint8_t index = (((x >> (VARIANT == xmrig::VARIANT_XTL ? 4 : 3)) & 6) | (x & 1)) << 1;
         vh ^= ((table >> index) & 0x3) << 28;
 
-        mem_out[1] = vh;
+        cn_store64(mem_out, 1, vh);
     }
 }
 
-void wow_soft_aes_compile_code(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM);
-void v4_soft_aes_compile_code(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM);
+size_t wow_soft_aes_compile_code(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM);
+size_t v4_soft_aes_compile_code(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM);
 
-template<xmrig::Algo ALGO, bool SOFT_AES, xmrig::Variant VARIANT>
-inline void cryptonight_single_hash(const uint8_t *__restrict__ input, size_t size, uint8_t *__restrict__ output, cryptonight_ctx **__restrict__ ctx, uint64_t height)
+struct cn_no_background
+{
+    inline void operator()() {}
+};
+
+
+template<xmrig::Algo ALGO, bool SOFT_AES, xmrig::Variant VARIANT, typename BACKGROUND>
+static inline void cn_single_main_loop(const uint8_t *__restrict__ input, size_t size, cryptonight_ctx **__restrict__ ctx, uint64_t height, BACKGROUND &background)
 {
     constexpr size_t MASK         = xmrig::cn_select_mask<ALGO>();
     constexpr size_t ITERATIONS   = xmrig::cn_select_iter<ALGO, VARIANT>();
-    constexpr size_t MEM          = xmrig::cn_select_memory<ALGO>();
     constexpr xmrig::Variant BASE = xmrig::cn_base_variant<VARIANT>();
 
-    static_assert(MASK > 0 && ITERATIONS > 0 && MEM > 0, "unsupported algorithm/variant");
-
-    if (BASE == xmrig::VARIANT_1 && size < 43) {
-        memset(output, 0, 32);
-        return;
-    }
-
-    xmrig::keccak(input, size, ctx[0]->state);
-
-    cn_explode_scratchpad<ALGO, MEM, SOFT_AES>((__m128i*) ctx[0]->state, (__m128i*) ctx[0]->memory);
-
     uint64_t* h0 = reinterpret_cast<uint64_t*>(ctx[0]->state);
-
-#ifndef XMRIG_NO_ASM
-    if (SOFT_AES && xmrig::cn_is_cryptonight_r<VARIANT>())
-    {
-        if (!ctx[0]->generated_code_data.match(VARIANT, height)) {
-            V4_Instruction code[256];
-            const int code_size = v4_random_math_init<VARIANT>(code, height);
-
-            if (VARIANT == xmrig::VARIANT_WOW)
-                wow_soft_aes_compile_code(code, code_size, reinterpret_cast<void*>(ctx[0]->generated_code), xmrig::ASM_NONE);
-            else if (VARIANT == xmrig::VARIANT_4)
-                v4_soft_aes_compile_code(code, code_size, reinterpret_cast<void*>(ctx[0]->generated_code), xmrig::ASM_NONE);
-
-            ctx[0]->generated_code_data.variant = VARIANT;
-            ctx[0]->generated_code_data.height = height;
-        }
-
-        ctx[0]->saes_table = (const uint32_t*)saes_table;
-        ctx[0]->generated_code(ctx[0]);
-    } else {
-#endif
-
-    const uint8_t* l0 = ctx[0]->memory;
+    uint8_t* l0 = ctx[0]->memory;
 
     VARIANT1_INIT(0);
     VARIANT2_INIT(0);
@@ -609,6 +724,10 @@ inline void cryptonight_single_hash(const uint8_t *__restrict__ input, size_t si
     uint64_t idx0 = al0;
 
     for (size_t i = 0; i < ITERATIONS; i++) {
+        if (cn_aborted(ctx[0], i)) {
+            return;
+        }
+
         __m128i cx;
         if (VARIANT == xmrig::VARIANT_TUBE || !SOFT_AES) {
             cx = _mm_load_si128((__m128i *) &l0[idx0 & MASK]);
@@ -619,7 +738,7 @@ inline void cryptonight_single_hash(const uint8_t *__restrict__ input, size_t si
             cx = aes_round_tweak_div(cx, ax0);
         }
         else if (SOFT_AES) {
-            cx = soft_aesenc((uint32_t*)&l0[idx0 & MASK], ax0, (const uint32_t*)saes_table);
+            cx = soft_aesenc(&l0[idx0 & MASK], ax0, (const uint32_t*)saes_table);
         }
         else {
             cx = _mm_aesenc_si128(cx, ax0);
@@ -634,8 +753,8 @@ inline void cryptonight_single_hash(const uint8_t *__restrict__ input, size_t si
         idx0 = _mm_cvtsi128_si64(cx);
 
         uint64_t hi, lo, cl, ch;
-        cl = ((uint64_t*) &l0[idx0 & MASK])[0];
-        ch = ((uint64_t*) &l0[idx0 & MASK])[1];
+        cl = cn_load64(&l0[idx0 & MASK], 0);
+        ch = cn_load64(&l0[idx0 & MASK], 1);
 
         if (BASE == xmrig::VARIANT_2) {
             if ((VARIANT == xmrig::VARIANT_WOW) || (VARIANT == xmrig::VARIANT_4)) {
@@ -662,14 +781,14 @@ inline void cryptonight_single_hash(const uint8_t *__restrict__ input, size_t si
         al0 += hi;
         ah0 += lo;
 
-        ((uint64_t*)&l0[idx0 & MASK])[0] = al0;
+        cn_store64(&l0[idx0 & MASK], 0, al0);
 
         if (BASE == xmrig::VARIANT_1 && (VARIANT == xmrig::VARIANT_TUBE || VARIANT == xmrig::VARIANT_RTO)) {
-            ((uint64_t*)&l0[idx0 & MASK])[1] = ah0 ^ tweak1_2_0 ^ al0;
+            cn_store64(&l0[idx0 & MASK], 1, ah0 ^ tweak1_2_0 ^ al0);
         } else if (BASE == xmrig::VARIANT_1) {
-            ((uint64_t*)&l0[idx0 & MASK])[1] = ah0 ^ tweak1_2_0;
+            cn_store64(&l0[idx0 & MASK], 1, ah0 ^ tweak1_2_0);
         } else {
-            ((uint64_t*)&l0[idx0 & MASK])[1] = ah0;
+            cn_store64(&l0[idx0 & MASK], 1, ah0);
         }
 
         al0 ^= cl;
@@ -677,11 +796,11 @@ inline void cryptonight_single_hash(const uint8_t *__restrict__ input, size_t si
         idx0 = al0;
 
         if (ALGO == xmrig::CRYPTONIGHT_HEAVY) {
-            int64_t n = ((int64_t*)&l0[idx0 & MASK])[0];
-            int32_t d = ((int32_t*)&l0[idx0 & MASK])[2];
+            int64_t n = static_cast<int64_t>(cn_load64(&l0[idx0 & MASK], 0));
+            int32_t d = static_cast<int32_t>(cn_load32(&l0[idx0 & MASK], 2));
             int64_t q = n / (d | 0x5);
 
-            ((int64_t*)&l0[idx0 & MASK])[0] = n ^ q;
+            cn_store64(&l0[idx0 & MASK], 0, n ^ q);
 
             if (VARIANT == xmrig::VARIANT_XHV) {
                 d = ~d;
@@ -695,12 +814,69 @@ inline void cryptonight_single_hash(const uint8_t *__restrict__ input, size_t si
         }
 
         bx0 = cx;
+
+        background();
+    }
+
+}
+
+
+template<xmrig::Algo ALGO, bool SOFT_AES, xmrig::Variant VARIANT>
+inline void cryptonight_single_hash(const uint8_t *__restrict__ input, size_t size, uint8_t *__restrict__ output, cryptonight_ctx **__restrict__ ctx, uint64_t height)
+{
+    constexpr size_t MASK         = xmrig::cn_select_mask<ALGO>();
+    constexpr size_t ITERATIONS   = xmrig::cn_select_iter<ALGO, VARIANT>();
+    constexpr size_t MEM          = xmrig::cn_select_memory<ALGO>();
+    constexpr xmrig::Variant BASE = xmrig::cn_base_variant<VARIANT>();
+
+    static_assert(MASK > 0 && ITERATIONS > 0 && MEM > 0, "unsupported algorithm/variant");
+
+    if (BASE == xmrig::VARIANT_1 && size < 43) {
+        memset(output, 0, 32);
+        return;
+    }
+
+    xmrig::keccak(input, size, ctx[0]->state);
+
+    cn_explode_scratchpad<ALGO, MEM, SOFT_AES>((__m128i*) ctx[0]->state, (__m128i*) ctx[0]->memory);
+
+    if (cn_aborted(ctx[0])) {
+        return;
     }
 
+    uint64_t* h0 = reinterpret_cast<uint64_t*>(ctx[0]->state);
+
+#ifndef XMRIG_NO_ASM
+    if (SOFT_AES && xmrig::cn_is_cryptonight_r<VARIANT>() && !ctx[0]->generated_code_data.match(VARIANT, height)) {
+        const xmrig::CnRCache::Compiler compile = VARIANT == xmrig::VARIANT_WOW ? wow_soft_aes_compile_code : v4_soft_aes_compile_code;
+        xmrig::CnRCache::release(reinterpret_cast<const void *>(ctx[0]->generated_code));
+        ctx[0]->generated_code = reinterpret_cast<cn_mainloop_fun_ms_abi>(xmrig::CnRCache::get(VARIANT, height, xmrig::ASM_NONE, 1, compile));
+
+        // Without code the C main loop below interprets the program and the next hash asks the cache again.
+        if (ctx[0]->generated_code) {
+            ctx[0]->generated_code_data.variant = VARIANT;
+            ctx[0]->generated_code_data.height = height;
+        }
+    }
+
+    if (SOFT_AES && xmrig::cn_is_cryptonight_r<VARIANT>() && ctx[0]->generated_code)
+    {
+        ctx[0]->saes_table = (const uint32_t*)saes_table;
+        ctx[0]->generated_code(ctx[0]);
+    } else {
+#endif
+
+    cn_no_background background;
+    cn_single_main_loop<ALGO, SOFT_AES, VARIANT>(input, size, ctx, height, background);
+
 #ifndef XMRIG_NO_ASM
     }
 #endif
         
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
     cn_implode_scratchpad<ALGO, MEM, SOFT_AES>((__m128i*) ctx[0]->memory, (__m128i*) ctx[0]->state);
 
     xmrig::keccakf(h0, 24);
@@ -708,6 +884,97 @@ inline void cryptonight_single_hash(const uint8_t *__restrict__ input, size_t si
 }
 
 
+template<xmrig::Algo ALGO, bool SOFT_AES, xmrig::Variant VARIANT>
+struct cn_pipeline_background
+{
+    static constexpr size_t MEM    = xmrig::cn_select_memory<ALGO>();
+    static constexpr size_t STRIDE = xmrig::cn_select_iter<ALGO, VARIANT>() / cn_implode_pass<ALGO, MEM, SOFT_AES>::BLOCKS;
+
+    static_assert(STRIDE > 0, "scratchpad passes do not fit into the main loop");
+
+    inline cn_pipeline_background() : countdown(STRIDE) {}
+
+    inline void operator()()
+    {
+        if (--countdown == 0) {
+            countdown = STRIDE;
+
+            explode.step();
+            implode.step();
+        }
+    }
+
+    cn_explode_pass<ALGO, MEM, SOFT_AES> explode;
+    cn_implode_pass<ALGO, MEM, SOFT_AES> implode;
+    size_t countdown;
+};
+
+
+/*
+ * Hashes the N inputs one after another, each in its own scratchpad, but overlaps the compute bound
+ * explode of hash i + 1 and implode of hash i - 1 with the memory bound main loop of hash i.
+ */
+template<xmrig::Algo ALGO, bool SOFT_AES, xmrig::Variant VARIANT>
+static void cn_pipelined_hash(const uint8_t *__restrict__ input, size_t size, uint8_t *__restrict__ output, cryptonight_ctx **__restrict__ ctx, uint64_t height, size_t ways)
+{
+    constexpr size_t MEM          = xmrig::cn_select_memory<ALGO>();
+    constexpr xmrig::Variant BASE = xmrig::cn_base_variant<VARIANT>();
+
+    if (BASE == xmrig::VARIANT_1 && size < 43) {
+        memset(output, 0, 32 * ways);
+        return;
+    }
+
+    xmrig::keccak(input, size, ctx[0]->state);
+    cn_explode_scratchpad<ALGO, MEM, SOFT_AES>((__m128i*) ctx[0]->state, (__m128i*) ctx[0]->memory);
+
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
+    for (size_t i = 0; i < ways; i++) {
+        cn_pipeline_background<ALGO, SOFT_AES, VARIANT> background;
+
+        if (i + 1 < ways) {
+            xmrig::keccak(input + (i + 1) * size, size, ctx[i + 1]->state);
+            background.explode.begin((__m128i*) ctx[i + 1]->state, (__m128i*) ctx[i + 1]->memory);
+        }
+
+        if (i > 0) {
+            background.implode.begin((__m128i*) ctx[i - 1]->memory, (__m128i*) ctx[i - 1]->state);
+        }
+
+        cn_single_main_loop<ALGO, SOFT_AES, VARIANT>(input + i * size, size, ctx + i, height, background);
+
+        if (cn_aborted(ctx[0])) {
+            return;
+        }
+
+        background.explode.finish();
+
+        if (i > 0) {
+            background.implode.finish();
+
+            xmrig::keccakf(reinterpret_cast<uint64_t*>(ctx[i - 1]->state), 24);
+            extra_hashes[ctx[i - 1]->state[0] & 3](ctx[i - 1]->state, 200, output + (i - 1) * 32);
+        }
+    }
+
+    cryptonight_ctx *last = ctx[ways - 1];
+    cn_implode_scratchpad<ALGO, MEM, SOFT_AES>((__m128i*) last->memory, (__m128i*) last->state);
+
+    xmrig::keccakf(reinterpret_cast<uint64_t*>(last->state), 24);
+    extra_hashes[last->state[0] & 3](last->state, 200, output + (ways - 1) * 32);
+}
+
+
+template<xmrig::Algo ALGO, bool SOFT_AES, xmrig::Variant VARIANT, size_t N>
+inline void cryptonight_pipelined_hash(const uint8_t *__restrict__ input, size_t size, uint8_t *__restrict__ output, cryptonight_ctx **__restrict__ ctx, uint64_t height)
+{
+    cn_pipelined_hash<ALGO, SOFT_AES, VARIANT>(input, size, output, ctx, height, N);
+}
+
+
 #ifndef XMRIG_NO_CN_GPU
 template<size_t ITER, uint32_t MASK>
 void cn_gpu_inner_avx(const uint8_t *spad, uint8_t *lpad);
@@ -729,6 +996,10 @@ inline void cryptonight_single_hash_gpu(const uint8_t *__restrict__ input, size_
     xmrig::keccak(input, size, ctx[0]->state);
     cn_explode_scratchpad_gpu<ALGO, MEM>(ctx[0]->state, ctx[0]->memory);
 
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
 #   ifdef _MSC_VER
     _control87(RC_NEAR, MCW_RC);
 #   else
@@ -741,6 +1012,10 @@ inline void cryptonight_single_hash_gpu(const uint8_t *__restrict__ input, size_
         cn_gpu_inner_ssse3<ITERATIONS, MASK>(ctx[0]->state, ctx[0]->memory);
     }
 
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
     cn_implode_scratchpad<xmrig::CRYPTONIGHT_HEAVY, MEM, SOFT_AES>((__m128i*) ctx[0]->memory, (__m128i*) ctx[0]->state);
 
     xmrig::keccakf((uint64_t*) ctx[0]->state, 24);
@@ -777,33 +1052,33 @@ extern xmrig::CpuThread::cn_mainloop_fun        cn_double_mainloop_ryzen_asm;
 extern xmrig::CpuThread::cn_mainloop_fun        cn_double_mainloop_bulldozer_asm;
 extern xmrig::CpuThread::cn_mainloop_double_fun cn_double_double_mainloop_sandybridge_asm;
 
-void wow_compile_code(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM);
-void v4_compile_code(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM);
-void wow_compile_code_double(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM);
-void v4_compile_code_double(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM);
+size_t wow_compile_code(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM);
+size_t v4_compile_code(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM);
+size_t wow_compile_code_double(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM);
+size_t v4_compile_code_double(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM);
 
 template<xmrig::Variant VARIANT>
-void cn_r_compile_code(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM)
+size_t cn_r_compile_code(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM)
 {
-    v4_compile_code(code, code_size, machine_code, ASM);
+    return v4_compile_code(code, code_size, machine_code, ASM);
 }
 
 template<xmrig::Variant VARIANT>
-void cn_r_compile_code_double(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM)
+size_t cn_r_compile_code_double(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM)
 {
-    v4_compile_code_double(code, code_size, machine_code, ASM);
+    return v4_compile_code_double(code, code_size, machine_code, ASM);
 }
 
 template<>
-void cn_r_compile_code<xmrig::VARIANT_WOW>(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM)
+size_t cn_r_compile_code<xmrig::VARIANT_WOW>(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM)
 {
-    wow_compile_code(code, code_size, machine_code, ASM);
+    return wow_compile_code(code, code_size, machine_code, ASM);
 }
 
 template<>
-void cn_r_compile_code_double<xmrig::VARIANT_WOW>(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM)
+size_t cn_r_compile_code_double<xmrig::VARIANT_WOW>(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM)
 {
-    wow_compile_code_double(code, code_size, machine_code, ASM);
+    return wow_compile_code_double(code, code_size, machine_code, ASM);
 }
 
 template<xmrig::Algo ALGO, xmrig::Variant VARIANT, xmrig::Assembly ASM>
@@ -812,9 +1087,15 @@ inline void cryptonight_single_hash_asm(const uint8_t *__restrict__ input, size_
     constexpr size_t MEM = xmrig::cn_select_memory<ALGO>();
 
     if (xmrig::cn_is_cryptonight_r<VARIANT>() && !ctx[0]->generated_code_data.match(VARIANT, height)) {
-        V4_Instruction code[256];
-        const int code_size = v4_random_math_init<VARIANT>(code, height);
-        cn_r_compile_code<VARIANT>(code, code_size, reinterpret_cast<void*>(ctx[0]->generated_code), ASM);
+        xmrig::CnRCache::release(reinterpret_cast<const void *>(ctx[0]->generated_code));
+        ctx[0]->generated_code = reinterpret_cast<cn_mainloop_fun_ms_abi>(xmrig::CnRCache::get(VARIANT, height, ASM, 1, cn_r_compile_code<VARIANT>));
+
+        // No machine code for this height yet, the C main loop interprets the program and the next hash asks the cache again.
+        if (!ctx[0]->generated_code) {
+            cryptonight_single_hash<ALGO, false, VARIANT>(input, size, output, ctx, height);
+            return;
+        }
+
         ctx[0]->generated_code_data.variant = VARIANT;
         ctx[0]->generated_code_data.height = height;
     }
@@ -822,6 +1103,10 @@ inline void cryptonight_single_hash_asm(const uint8_t *__restrict__ input, size_
     xmrig::keccak(input, size, ctx[0]->state);
     cn_explode_scratchpad<ALGO, MEM, false>(reinterpret_cast<__m128i*>(ctx[0]->state), reinterpret_cast<__m128i*>(ctx[0]->memory));
 
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
     if (VARIANT == xmrig::VARIANT_2) {
         if (ASM == xmrig::ASM_INTEL) {
             cnv2_mainloop_ivybridge_asm(ctx[0]);
@@ -884,21 +1169,34 @@ inline void cryptonight_single_hash_asm(const uint8_t *__restrict__ input, size_
         ctx[0]->generated_code(ctx[0]);
     }
 
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
     cn_implode_scratchpad<ALGO, MEM, false>(reinterpret_cast<__m128i*>(ctx[0]->memory), reinterpret_cast<__m128i*>(ctx[0]->state));
     xmrig::keccakf(reinterpret_cast<uint64_t*>(ctx[0]->state), 24);
     extra_hashes[ctx[0]->state[0] & 3](ctx[0]->state, 200, output);
 }
 
 
+template<xmrig::Algo ALGO, bool SOFT_AES, xmrig::Variant VARIANT>
+inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t size, uint8_t *__restrict__ output, cryptonight_ctx **__restrict__ ctx, uint64_t height);
+
+
 template<xmrig::Algo ALGO, xmrig::Variant VARIANT, xmrig::Assembly ASM>
 inline void cryptonight_double_hash_asm(const uint8_t *__restrict__ input, size_t size, uint8_t *__restrict__ output, cryptonight_ctx **__restrict__ ctx, uint64_t height)
 {
     constexpr size_t MEM = xmrig::cn_select_memory<ALGO>();
 
     if (xmrig::cn_is_cryptonight_r<VARIANT>() && !ctx[0]->generated_code_double_data.match(VARIANT, height)) {
-        V4_Instruction code[256];
-        const int code_size = v4_random_math_init<VARIANT>(code, height);
-        cn_r_compile_code_double<VARIANT>(code, code_size, reinterpret_cast<void*>(ctx[0]->generated_code_double), ASM);
+        xmrig::CnRCache::release(reinterpret_cast<const void *>(ctx[0]->generated_code_double));
+        ctx[0]->generated_code_double = reinterpret_cast<cn_mainloop_double_fun_ms_abi>(xmrig::CnRCache::get(VARIANT, height, ASM, 2, cn_r_compile_code_double<VARIANT>));
+
+        if (!ctx[0]->generated_code_double) {
+            cryptonight_double_hash<ALGO, false, VARIANT>(input, size, output, ctx, height);
+            return;
+        }
+
         ctx[0]->generated_code_double_data.variant = VARIANT;
         ctx[0]->generated_code_double_data.height = height;
     }
@@ -909,6 +1207,10 @@ inline void cryptonight_double_hash_asm(const uint8_t *__restrict__ input, size_
     cn_explode_scratchpad<ALGO, MEM, false>(reinterpret_cast<__m128i*>(ctx[0]->state), reinterpret_cast<__m128i*>(ctx[0]->memory));
     cn_explode_scratchpad<ALGO, MEM, false>(reinterpret_cast<__m128i*>(ctx[1]->state), reinterpret_cast<__m128i*>(ctx[1]->memory));
 
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
     if (VARIANT == xmrig::VARIANT_2) {
         cnv2_double_mainloop_sandybridge_asm(ctx[0], ctx[1]);
     }
@@ -931,6 +1233,10 @@ inline void cryptonight_double_hash_asm(const uint8_t *__restrict__ input, size_
         ctx[0]->generated_code_double(ctx[0], ctx[1]);
     }
 
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
     cn_implode_scratchpad<ALGO, MEM, false>(reinterpret_cast<__m128i*>(ctx[0]->memory), reinterpret_cast<__m128i*>(ctx[0]->state));
     cn_implode_scratchpad<ALGO, MEM, false>(reinterpret_cast<__m128i*>(ctx[1]->memory), reinterpret_cast<__m128i*>(ctx[1]->state));
 
@@ -959,8 +1265,8 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
     xmrig::keccak(input,        size, ctx[0]->state);
     xmrig::keccak(input + size, size, ctx[1]->state);
 
-    const uint8_t* l0 = ctx[0]->memory;
-    const uint8_t* l1 = ctx[1]->memory;
+    uint8_t* l0 = ctx[0]->memory;
+    uint8_t* l1 = ctx[1]->memory;
     uint64_t* h0 = reinterpret_cast<uint64_t*>(ctx[0]->state);
     uint64_t* h1 = reinterpret_cast<uint64_t*>(ctx[1]->state);
 
@@ -975,6 +1281,10 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
     cn_explode_scratchpad<ALGO, MEM, SOFT_AES>((__m128i*) h0, (__m128i*) l0);
     cn_explode_scratchpad<ALGO, MEM, SOFT_AES>((__m128i*) h1, (__m128i*) l1);
 
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
     uint64_t al0 = h0[0] ^ h0[4];
     uint64_t al1 = h1[0] ^ h1[4];
     uint64_t ah0 = h0[1] ^ h0[5];
@@ -989,6 +1299,10 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
     uint64_t idx1 = al1;
 
     for (size_t i = 0; i < ITERATIONS; i++) {
+        if (cn_aborted(ctx[0], i)) {
+            return;
+        }
+
         __m128i cx0, cx1;
         if (VARIANT == xmrig::VARIANT_TUBE || !SOFT_AES) {
             cx0 = _mm_load_si128((__m128i *) &l0[idx0 & MASK]);
@@ -1002,8 +1316,8 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
             cx1 = aes_round_tweak_div(cx1, ax1);
         }
         else if (SOFT_AES) {
-            cx0 = soft_aesenc((uint32_t*)&l0[idx0 & MASK], ax0, (const uint32_t*)saes_table);
-            cx1 = soft_aesenc((uint32_t*)&l1[idx1 & MASK], ax1, (const uint32_t*)saes_table);
+            cx0 = soft_aesenc(&l0[idx0 & MASK], ax0, (const uint32_t*)saes_table);
+            cx1 = soft_aesenc(&l1[idx1 & MASK], ax1, (const uint32_t*)saes_table);
         }
         else {
             cx0 = _mm_aesenc_si128(cx0, ax0);
@@ -1022,8 +1336,8 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
         idx1 = _mm_cvtsi128_si64(cx1);
 
         uint64_t hi, lo, cl, ch;
-        cl = ((uint64_t*) &l0[idx0 & MASK])[0];
-        ch = ((uint64_t*) &l0[idx0 & MASK])[1];
+        cl = cn_load64(&l0[idx0 & MASK], 0);
+        ch = cn_load64(&l0[idx0 & MASK], 1);
 
         if (BASE == xmrig::VARIANT_2) {
             if ((VARIANT == xmrig::VARIANT_WOW) || (VARIANT == xmrig::VARIANT_4)) {
@@ -1050,14 +1364,14 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
         al0 += hi;
         ah0 += lo;
 
-        ((uint64_t*)&l0[idx0 & MASK])[0] = al0;
+        cn_store64(&l0[idx0 & MASK], 0, al0);
 
         if (BASE == xmrig::VARIANT_1 && (VARIANT == xmrig::VARIANT_TUBE || VARIANT == xmrig::VARIANT_RTO)) {
-            ((uint64_t*) &l0[idx0 & MASK])[1] = ah0 ^ tweak1_2_0 ^ al0;
+            cn_store64(&l0[idx0 & MASK], 1, ah0 ^ tweak1_2_0 ^ al0);
         } else if (BASE == xmrig::VARIANT_1) {
-            ((uint64_t*) &l0[idx0 & MASK])[1] = ah0 ^ tweak1_2_0;
+            cn_store64(&l0[idx0 & MASK], 1, ah0 ^ tweak1_2_0);
         } else {
-            ((uint64_t*) &l0[idx0 & MASK])[1] = ah0;
+            cn_store64(&l0[idx0 & MASK], 1, ah0);
         }
 
         al0 ^= cl;
@@ -1065,11 +1379,11 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
         idx0 = al0;
 
         if (ALGO == xmrig::CRYPTONIGHT_HEAVY) {
-            int64_t n = ((int64_t*)&l0[idx0 & MASK])[0];
-            int32_t d = ((int32_t*)&l0[idx0 & MASK])[2];
+            int64_t n = static_cast<int64_t>(cn_load64(&l0[idx0 & MASK], 0));
+            int32_t d = static_cast<int32_t>(cn_load32(&l0[idx0 & MASK], 2));
             int64_t q = n / (d | 0x5);
 
-            ((int64_t*)&l0[idx0 & MASK])[0] = n ^ q;
+            cn_store64(&l0[idx0 & MASK], 0, n ^ q);
 
             if (VARIANT == xmrig::VARIANT_XHV) {
                 d = ~d;
@@ -1078,8 +1392,8 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
             idx0 = d ^ q;
         }
 
-        cl = ((uint64_t*) &l1[idx1 & MASK])[0];
-        ch = ((uint64_t*) &l1[idx1 & MASK])[1];
+        cl = cn_load64(&l1[idx1 & MASK], 0);
+        ch = cn_load64(&l1[idx1 & MASK], 1);
 
         if (BASE == xmrig::VARIANT_2) {
             if ((VARIANT == xmrig::VARIANT_WOW) || (VARIANT == xmrig::VARIANT_4)) {
@@ -1106,14 +1420,14 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
         al1 += hi;
         ah1 += lo;
 
-        ((uint64_t*)&l1[idx1 & MASK])[0] = al1;
+        cn_store64(&l1[idx1 & MASK], 0, al1);
 
         if (BASE == xmrig::VARIANT_1 && (VARIANT == xmrig::VARIANT_TUBE || VARIANT == xmrig::VARIANT_RTO)) {
-            ((uint64_t*)&l1[idx1 & MASK])[1] = ah1 ^ tweak1_2_1 ^ al1;
+            cn_store64(&l1[idx1 & MASK], 1, ah1 ^ tweak1_2_1 ^ al1);
         } else if (BASE == xmrig::VARIANT_1) {
-            ((uint64_t*)&l1[idx1 & MASK])[1] = ah1 ^ tweak1_2_1;
+            cn_store64(&l1[idx1 & MASK], 1, ah1 ^ tweak1_2_1);
         } else {
-            ((uint64_t*)&l1[idx1 & MASK])[1] = ah1;
+            cn_store64(&l1[idx1 & MASK], 1, ah1);
         }
 
         al1 ^= cl;
@@ -1121,11 +1435,11 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
         idx1 = al1;
 
         if (ALGO == xmrig::CRYPTONIGHT_HEAVY) {
-            int64_t n = ((int64_t*)&l1[idx1 & MASK])[0];
-            int32_t d = ((int32_t*)&l1[idx1 & MASK])[2];
+            int64_t n = static_cast<int64_t>(cn_load64(&l1[idx1 & MASK], 0));
+            int32_t d = static_cast<int32_t>(cn_load32(&l1[idx1 & MASK], 2));
             int64_t q = n / (d | 0x5);
 
-            ((int64_t*)&l1[idx1 & MASK])[0] = n ^ q;
+            cn_store64(&l1[idx1 & MASK], 0, n ^ q);
 
             if (VARIANT == xmrig::VARIANT_XHV) {
                 d = ~d;
@@ -1143,6 +1457,10 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
         bx10 = cx1;
     }
 
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
     cn_implode_scratchpad<ALGO, MEM, SOFT_AES>((__m128i*) l0, (__m128i*) h0);
     cn_implode_scratchpad<ALGO, MEM, SOFT_AES>((__m128i*) l1, (__m128i*) h1);
 
@@ -1179,8 +1497,8 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
 #define CN_STEP3(part, a, b0, b1, c, l, ptr, idx)     \
     idx = _mm_cvtsi128_si64(c);                       \
     ptr = reinterpret_cast<__m128i*>(&l[idx & MASK]); \
-    uint64_t cl##part = ((uint64_t*)ptr)[0];          \
-    uint64_t ch##part = ((uint64_t*)ptr)[1];
+    uint64_t cl##part = cn_load64(ptr, 0);          \
+    uint64_t ch##part = cn_load64(ptr, 1);
 
 
 #define CN_STEP4(part, a, b0, b1, c, l, mc, ptr, idx)   \
@@ -1216,7 +1534,7 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
                                                         \
         if (VARIANT == xmrig::VARIANT_TUBE ||           \
             VARIANT == xmrig::VARIANT_RTO) {            \
-            ((uint64_t*)ptr)[1] ^= ((uint64_t*)ptr)[0]; \
+            cn_store64(ptr, 1, cn_load64(ptr, 1) ^ cn_load64(ptr, 0)); \
         }                                               \
     } else {                                            \
         _mm_store_si128(ptr, a);                        \
@@ -1226,10 +1544,10 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
     idx = _mm_cvtsi128_si64(a);                         \
                                                         \
     if (ALGO == xmrig::CRYPTONIGHT_HEAVY) {             \
-        int64_t n = ((int64_t*)&l[idx & MASK])[0];      \
-        int32_t d = ((int32_t*)&l[idx & MASK])[2];      \
+        int64_t n = static_cast<int64_t>(cn_load64(&l[idx & MASK], 0));      \
+        int32_t d = static_cast<int32_t>(cn_load32(&l[idx & MASK], 2));      \
         int64_t q = n / (d | 0x5);                      \
-        ((int64_t*)&l[idx & MASK])[0] = n ^ q;          \
+        cn_store64(&l[idx & MASK], 0, n ^ q);          \
         if (VARIANT == xmrig::VARIANT_XHV) {            \
             d = ~d;                                     \
         }                                               \
@@ -1247,8 +1565,7 @@ inline void cryptonight_double_hash(const uint8_t *__restrict__ input, size_t si
     __m128i division_result_xmm_##n;                                                             \
     __m128i sqrt_result_xmm_##n;                                                                 \
     if (BASE == xmrig::VARIANT_1) {                                                              \
-        mc##n = _mm_set_epi64x(*reinterpret_cast<const uint64_t*>(input + n * size + 35) ^       \
-                               *(reinterpret_cast<const uint64_t*>((ctx)->state) + 24), 0);      \
+        mc##n = _mm_set_epi64x(cn_load64(input + n * size + 35, 0) ^ cn_load64((ctx)->state, 24), 0); \
     }                                                                                            \
     if (BASE == xmrig::VARIANT_2) {                                                              \
         division_result_xmm_##n = _mm_cvtsi64_si128(h##n[12]);                                   \
@@ -1279,6 +1596,10 @@ inline void cryptonight_triple_hash(const uint8_t *__restrict__ input, size_t si
         cn_explode_scratchpad<ALGO, MEM, SOFT_AES>(reinterpret_cast<__m128i*>(ctx[i]->state), reinterpret_cast<__m128i*>(ctx[i]->memory));
     }
 
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
     uint8_t* l0  = ctx[0]->memory;
     uint8_t* l1  = ctx[1]->memory;
     uint8_t* l2  = ctx[2]->memory;
@@ -1297,6 +1618,10 @@ inline void cryptonight_triple_hash(const uint8_t *__restrict__ input, size_t si
     idx2 = _mm_cvtsi128_si64(ax2);
 
     for (size_t i = 0; i < ITERATIONS; i++) {
+        if (cn_aborted(ctx[0], i)) {
+            return;
+        }
+
         uint64_t hi, lo;
         __m128i *ptr0, *ptr1, *ptr2;
 
@@ -1317,6 +1642,10 @@ inline void cryptonight_triple_hash(const uint8_t *__restrict__ input, size_t si
         CN_STEP4(2, ax2, bx20, bx21, cx2, l2, mc2, ptr2, idx2);
     }
 
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
     for (size_t i = 0; i < 3; i++) {
         cn_implode_scratchpad<ALGO, MEM, SOFT_AES>(reinterpret_cast<__m128i*>(ctx[i]->memory), reinterpret_cast<__m128i*>(ctx[i]->state));
         xmrig::keccakf(reinterpret_cast<uint64_t*>(ctx[i]->state), 24);
@@ -1343,6 +1672,10 @@ inline void cryptonight_quad_hash(const uint8_t *__restrict__ input, size_t size
         cn_explode_scratchpad<ALGO, MEM, SOFT_AES>(reinterpret_cast<__m128i*>(ctx[i]->state), reinterpret_cast<__m128i*>(ctx[i]->memory));
     }
 
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
     uint8_t* l0  = ctx[0]->memory;
     uint8_t* l1  = ctx[1]->memory;
     uint8_t* l2  = ctx[2]->memory;
@@ -1366,6 +1699,10 @@ inline void cryptonight_quad_hash(const uint8_t *__restrict__ input, size_t size
 
     for (size_t i = 0; i < ITERATIONS; i++)
     {
+        if (cn_aborted(ctx[0], i)) {
+            return;
+        }
+
         uint64_t hi, lo;
         __m128i *ptr0, *ptr1, *ptr2, *ptr3;
 
@@ -1390,6 +1727,10 @@ inline void cryptonight_quad_hash(const uint8_t *__restrict__ input, size_t size
         CN_STEP4(3, ax3, bx30, bx31, cx3, l3, mc3, ptr3, idx3);
     }
 
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
     for (size_t i = 0; i < 4; i++) {
         cn_implode_scratchpad<ALGO, MEM, SOFT_AES>(reinterpret_cast<__m128i*>(ctx[i]->memory), reinterpret_cast<__m128i*>(ctx[i]->state));
         xmrig::keccakf(reinterpret_cast<uint64_t*>(ctx[i]->state), 24);
@@ -1416,6 +1757,10 @@ inline void cryptonight_penta_hash(const uint8_t *__restrict__ input, size_t siz
         cn_explode_scratchpad<ALGO, MEM, SOFT_AES>(reinterpret_cast<__m128i*>(ctx[i]->state), reinterpret_cast<__m128i*>(ctx[i]->memory));
     }
 
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
     uint8_t* l0  = ctx[0]->memory;
     uint8_t* l1  = ctx[1]->memory;
     uint8_t* l2  = ctx[2]->memory;
@@ -1443,6 +1788,10 @@ inline void cryptonight_penta_hash(const uint8_t *__restrict__ input, size_t siz
 
     for (size_t i = 0; i < ITERATIONS; i++)
     {
+        if (cn_aborted(ctx[0], i)) {
+            return;
+        }
+
         uint64_t hi, lo;
         __m128i *ptr0, *ptr1, *ptr2, *ptr3, *ptr4;
 
@@ -1471,6 +1820,10 @@ inline void cryptonight_penta_hash(const uint8_t *__restrict__ input, size_t siz
         CN_STEP4(4, ax4, bx40, bx41, cx4, l4, mc4, ptr4, idx4);
     }
 
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
     for (size_t i = 0; i < 5; i++) {
         cn_implode_scratchpad<ALGO, MEM, SOFT_AES>(reinterpret_cast<__m128i*>(ctx[i]->memory), reinterpret_cast<__m128i*>(ctx[i]->state));
         xmrig::keccakf(reinterpret_cast<uint64_t*>(ctx[i]->state), 24);
@@ -1478,4 +1831,140 @@ inline void cryptonight_penta_hash(const uint8_t *__restrict__ input, size_t siz
     }
 }
 
+
+/*
+ * Generic N-way kernel for the small scratchpad algorithms (cn-lite, cn-pico), used for 8 and 16 ways.
+ * Lane state lives in arrays and every step loops over the lanes, so all loads of one step are in flight together.
+ */
+template<xmrig::Algo ALGO, bool SOFT_AES, xmrig::Variant VARIANT, size_t N>
+inline void cryptonight_multi_hash(const uint8_t *__restrict__ input, size_t size, uint8_t *__restrict__ output, cryptonight_ctx **__restrict__ ctx, uint64_t height)
+{
+    constexpr size_t MASK         = xmrig::cn_select_mask<ALGO>();
+    constexpr size_t ITERATIONS   = xmrig::cn_select_iter<ALGO, VARIANT>();
+    constexpr size_t MEM          = xmrig::cn_select_memory<ALGO>();
+    constexpr xmrig::Variant BASE = xmrig::cn_base_variant<VARIANT>();
+
+    static_assert(ALGO != xmrig::CRYPTONIGHT_HEAVY && VARIANT != xmrig::VARIANT_GPU && !xmrig::cn_is_cryptonight_r<VARIANT>(), "unsupported algorithm/variant");
+
+    if (BASE == xmrig::VARIANT_1 && size < 43) {
+        memset(output, 0, 32 * N);
+        return;
+    }
+
+    for (size_t i = 0; i < N; i++) {
+        xmrig::keccak(input + size * i, size, ctx[i]->state);
+        cn_explode_scratchpad<ALGO, MEM, SOFT_AES>(reinterpret_cast<__m128i*>(ctx[i]->state), reinterpret_cast<__m128i*>(ctx[i]->memory));
+    }
+
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
+    uint8_t *l[N];
+    __m128i *ptr[N];
+    __m128i ax[N], bx0[N], bx1[N], cx[N], mc[N];
+    __m128i division_result_xmm[N], sqrt_result_xmm[N];
+    uint64_t idx[N], cl[N], ch[N];
+
+    for (size_t k = 0; k < N; k++) {
+        const uint64_t *h = reinterpret_cast<const uint64_t*>(ctx[k]->state);
+
+        l[k]   = ctx[k]->memory;
+        ax[k]  = _mm_set_epi64x(h[1] ^ h[5], h[0] ^ h[4]);
+        bx0[k] = _mm_set_epi64x(h[3] ^ h[7], h[2] ^ h[6]);
+        bx1[k] = _mm_set_epi64x(h[9] ^ h[11], h[8] ^ h[10]);
+        mc[k]  = _mm_setzero_si128();
+        idx[k] = h[0] ^ h[4];
+
+        if (BASE == xmrig::VARIANT_1) {
+            mc[k] = _mm_set_epi64x(cn_load64(input + k * size + 35, 0) ^ h[24], 0);
+        }
+
+        division_result_xmm[k] = _mm_cvtsi64_si128(h[12]);
+        sqrt_result_xmm[k]     = _mm_cvtsi64_si128(h[13]);
+    }
+
+    VARIANT2_SET_ROUNDING_MODE();
+
+    for (size_t i = 0; i < ITERATIONS; i++) {
+        if (cn_aborted(ctx[0], i)) {
+            return;
+        }
+
+        for (size_t k = 0; k < N; k++) {
+            ptr[k] = reinterpret_cast<__m128i*>(&l[k][idx[k] & MASK]);
+            cx[k]  = _mm_load_si128(ptr[k]);
+        }
+
+        for (size_t k = 0; k < N; k++) {
+            if (SOFT_AES) {
+                cx[k] = soft_aesenc(&cx[k], ax[k], (const uint32_t*)saes_table);
+            } else {
+                cx[k] = _mm_aesenc_si128(cx[k], ax[k]);
+            }
+
+            if (BASE == xmrig::VARIANT_1 || BASE == xmrig::VARIANT_2) {
+                cryptonight_monero_tweak<VARIANT, BASE>((uint64_t*)ptr[k], l[k], idx[k] & MASK, ax[k], bx0[k], bx1[k], cx[k]);
+            } else {
+                _mm_store_si128(ptr[k], _mm_xor_si128(bx0[k], cx[k]));
+            }
+        }
+
+        for (size_t k = 0; k < N; k++) {
+            idx[k] = _mm_cvtsi128_si64(cx[k]);
+            ptr[k] = reinterpret_cast<__m128i*>(&l[k][idx[k] & MASK]);
+            cl[k]  = cn_load64(ptr[k], 0);
+            ch[k]  = cn_load64(ptr[k], 1);
+        }
+
+        for (size_t k = 0; k < N; k++) {
+            uint64_t hi, lo;
+
+            if (BASE == xmrig::VARIANT_2) {
+                __m128i &division_result_xmm_lane = division_result_xmm[k];
+                __m128i &sqrt_result_xmm_lane     = sqrt_result_xmm[k];
+
+                VARIANT2_INTEGER_MATH(lane, cl[k], cx[k]);
+            }
+
+            lo = __umul128(idx[k], cl[k], &hi);
+
+            if (BASE == xmrig::VARIANT_2) {
+                VARIANT2_SHUFFLE2(l[k], idx[k] & MASK, ax[k], bx0[k], bx1[k], hi, lo, (VARIANT == xmrig::VARIANT_RWZ ? 1 : 0));
+            }
+
+            ax[k] = _mm_add_epi64(ax[k], _mm_set_epi64x(lo, hi));
+
+            if (BASE == xmrig::VARIANT_1) {
+                _mm_store_si128(ptr[k], _mm_xor_si128(ax[k], mc[k]));
+
+                if (VARIANT == xmrig::VARIANT_RTO) {
+                    cn_store64(ptr[k], 1, cn_load64(ptr[k], 1) ^ cn_load64(ptr[k], 0));
+                }
+            } else {
+                _mm_store_si128(ptr[k], ax[k]);
+            }
+
+            ax[k]  = _mm_xor_si128(ax[k], _mm_set_epi64x(ch[k], cl[k]));
+            idx[k] = _mm_cvtsi128_si64(ax[k]);
+
+            if (BASE == xmrig::VARIANT_2) {
+                bx1[k] = bx0[k];
+            }
+
+            bx0[k] = cx[k];
+        }
+    }
+
+    if (cn_aborted(ctx[0])) {
+        return;
+    }
+
+    for (size_t i = 0; i < N; i++) {
+        cn_implode_scratchpad<ALGO, MEM, SOFT_AES>(reinterpret_cast<__m128i*>(ctx[i]->memory), reinterpret_cast<__m128i*>(ctx[i]->state));
+        xmrig::keccakf(reinterpret_cast<uint64_t*>(ctx[i]->state), 24);
+        extra_hashes[ctx[i]->state[0] & 3](ctx[i]->state, 200, output + 32 * i);
+    }
+}
+
 #endif /* XMRIG_CRYPTONIGHT_X86_H */
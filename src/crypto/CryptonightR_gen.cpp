@@ -51,7 +51,7 @@ static inline void add_random_math(uint8_t* &p, const V4_Instruction* code, int
             break;
         }
 
-        uint8_t opcode = (inst.opcode == MUL) ? inst.opcode : (inst.opcode + 2);
+        uint8_t opcode = (inst.opcode == mul_) ? inst.opcode : (inst.opcode + 2);
         uint8_t dst_index = inst.dst_index;
         uint8_t src_index = inst.src_index;
 
@@ -60,8 +60,8 @@ static inline void add_random_math(uint8_t* &p, const V4_Instruction* code, int
         const uint8_t c = opcode | (dst_index << V4_OPCODE_BITS) | (((src_index == 8) ? dst_index : src_index) << (V4_OPCODE_BITS + V4_DST_INDEX_BITS));
 
         switch (inst.opcode) {
-        case ROR:
-        case ROL:
+        case ror_:
+        case rol_:
             if (b != prev_rot_src) {
                 prev_rot_src = b;
                 add_code(p, instructions_mov[c], instructions_mov[c + 1]);
@@ -75,7 +75,7 @@ static inline void add_random_math(uint8_t* &p, const V4_Instruction* code, int
 
         void_func begin = instructions[c];
 
-        if ((ASM = xmrig::ASM_BULLDOZER) && (inst.opcode == MUL) && !is_64_bit) {
+        if ((ASM = xmrig::ASM_BULLDOZER) && (inst.opcode == mul_) && !is_64_bit) {
             // AMD Bulldozer has latency 4 for 32-bit IMUL and 6 for 64-bit IMUL
             // Always use 32-bit IMUL for AMD Bulldozer in 32-bit mode - skip prefix 0x48 and change 0x49 to 0x41
             uint8_t* prefix = reinterpret_cast<uint8_t*>(begin);
@@ -89,7 +89,7 @@ static inline void add_random_math(uint8_t* &p, const V4_Instruction* code, int
 
         add_code(p, begin, instructions[c + 1]);
 
-        if (inst.opcode == ADD) {
+        if (inst.opcode == add_) {
             *(uint32_t*)(p - sizeof(uint32_t) - (is_64_bit ? 3 : 0)) = inst.C;
             if (is_64_bit) {
                 prev_rot_src = (uint32_t)(-1);
@@ -98,7 +98,7 @@ static inline void add_random_math(uint8_t* &p, const V4_Instruction* code, int
     }
 }
 
-void wow_compile_code(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM)
+size_t wow_compile_code(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM)
 {
     uint8_t* p0 = reinterpret_cast<uint8_t*>(machine_code);
     uint8_t* p = p0;
@@ -110,9 +110,11 @@ void wow_compile_code(const V4_Instruction* code, int code_size, void* machine_c
     add_code(p, CryptonightWOW_template_part3, CryptonightWOW_template_end);
 
     Mem::flushInstructionCache(machine_code, p - p0);
+
+    return p - p0;
 }
 
-void v4_compile_code(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM)
+size_t v4_compile_code(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM)
 {
     uint8_t* p0 = reinterpret_cast<uint8_t*>(machine_code);
     uint8_t* p = p0;
@@ -124,9 +126,11 @@ void v4_compile_code(const V4_Instruction* code, int code_size, void* machine_co
     add_code(p, CryptonightR_template_part3, CryptonightR_template_end);
 
     Mem::flushInstructionCache(machine_code, p - p0);
+
+    return p - p0;
 }
 
-void wow_compile_code_double(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM)
+size_t wow_compile_code_double(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM)
 {
     uint8_t* p0 = reinterpret_cast<uint8_t*>(machine_code);
     uint8_t* p = p0;
@@ -140,9 +144,11 @@ void wow_compile_code_double(const V4_Instruction* code, int code_size, void* ma
     add_code(p, CryptonightWOW_template_double_part4, CryptonightWOW_template_double_end);
 
     Mem::flushInstructionCache(machine_code, p - p0);
+
+    return p - p0;
 }
 
-void v4_compile_code_double(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM)
+size_t v4_compile_code_double(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM)
 {
     uint8_t* p0 = reinterpret_cast<uint8_t*>(machine_code);
     uint8_t* p = p0;
@@ -156,9 +162,11 @@ void v4_compile_code_double(const V4_Instruction* code, int code_size, void* mac
     add_code(p, CryptonightR_template_double_part4, CryptonightR_template_double_end);
 
     Mem::flushInstructionCache(machine_code, p - p0);
+
+    return p - p0;
 }
 
-void wow_soft_aes_compile_code(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM)
+size_t wow_soft_aes_compile_code(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM)
 {
     uint8_t* p0 = reinterpret_cast<uint8_t*>(machine_code);
     uint8_t* p = p0;
@@ -170,9 +178,11 @@ void wow_soft_aes_compile_code(const V4_Instruction* code, int code_size, void*
     add_code(p, CryptonightWOW_soft_aes_template_part3, CryptonightWOW_soft_aes_template_end);
 
     Mem::flushInstructionCache(machine_code, p - p0);
+
+    return p - p0;
 }
 
-void v4_soft_aes_compile_code(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM)
+size_t v4_soft_aes_compile_code(const V4_Instruction* code, int code_size, void* machine_code, xmrig::Assembly ASM)
 {
     uint8_t* p0 = reinterpret_cast<uint8_t*>(machine_code);
     uint8_t* p = p0;
@@ -184,4 +194,6 @@ void v4_soft_aes_compile_code(const V4_Instruction* code, int code_size, void* m
     add_code(p, CryptonightR_soft_aes_template_part3, CryptonightR_soft_aes_template_end);
 
     Mem::flushInstructionCache(machine_code, p - p0);
+
+    return p - p0;
 }
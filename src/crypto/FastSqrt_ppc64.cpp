@@ -0,0 +1,77 @@
+/* XMRig
+ * Copyright 2018      SChernykh   <https://github.com/SChernykh> 
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <chrono>
+#include <inttypes.h>
+
+
+#include "common/log/Log.h"
+#include "crypto/FastSqrt_ppc64.h"
+
+
+bool SqrtV2::table = true;
+
+
+namespace {
+
+
+constexpr size_t kMemory = 2 * 1024 * 1024 / sizeof(uint64_t);
+constexpr size_t kRounds = 1 << 18;
+
+
+// A dependent chain of square roots with a random read-modify-write into a scratchpad sized
+// buffer after each one, the shape of the VARIANT2_INTEGER_MATH main loop.
+template<bool TABLE>
+int64_t run(uint64_t *memory, uint64_t &seed)
+{
+    const auto start = std::chrono::steady_clock::now();
+    uint64_t n = seed;
+
+    for (size_t i = 0; i < kRounds; ++i) {
+        uint64_t &line = memory[(n >> 7) & (kMemory - 1)];
+        line ^= n;
+        n = (line * 0x5851f42d4c957f2dULL + i) ^ (TABLE ? SqrtV2::get(n) : SqrtV2::compute(n));
+    }
+
+    seed = n;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+} // namespace
+
+
+void SqrtV2::select()
+{
+    uint64_t *memory = new uint64_t[kMemory]();
+    uint64_t seed    = 0x9e3779b97f4a7c15ULL;
+    int64_t tableNs  = INT64_MAX;
+    int64_t fsqrtNs  = INT64_MAX;
+
+    for (int i = 0; i < 3; ++i) {
+        tableNs = std::min(tableNs, run<true>(memory, seed));
+        fsqrtNs = std::min(fsqrtNs, run<false>(memory, seed));
+    }
+
+    delete [] memory;
+
+    table = tableNs <= fsqrtNs;
+
+    LOG_DEBUG("sqrt v2: table %" PRId64 " ns, fsqrt %" PRId64 " ns, using %s", tableNs, fsqrtNs, table ? "table" : "fsqrt");
+}
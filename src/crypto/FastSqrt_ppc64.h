@@ -21,6 +21,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <string.h>
 
 static const uint32_t SqrtV2Table[65536] = {
 	0x0u,0xffff8000u,0x7fffcu,0xfffe8000u,0xffff0u,0xfffd8008u,0x17ffdcu,0xfffc8010u,
@@ -8243,6 +8244,31 @@ struct SqrtV2
 		const uint64_t x1 = x + 1;
 		return x + static_cast<uint64_t>((s * (x1 - s) + (x1 << 32) - n) >> 63);
 	}
+
+	// fsqrt estimate with the exact integer fix-up from the reference implementation, it gives the
+	// table result for every input in any rounding mode. fsqrt is emitted directly so -Ofast can
+	// not turn it into a reciprocal estimate.
+	static FORCEINLINE uint64_t compute(const uint64_t n)
+	{
+		uint64_t r = (n >> 12) + (1023ULL << 52);
+		double x;
+
+		memcpy(&x, &r, sizeof(x));
+		__asm__("fsqrt %0, %1" : "=d"(x) : "d"(x));
+		memcpy(&r, &x, sizeof(r));
+
+		r = (r >> 19) - (2046ULL << 32);
+
+		const uint64_t s = r >> 1;
+		const uint64_t b = r & 1;
+		const uint64_t r2 = s * (s + b) + (r << 32);
+		return r + ((r2 + b > n) ? -1 : 0) + ((r2 + (1ULL << 32) < n - s) ? 1 : 0);
+	}
+
+	// The table is 256 KB of L2 that the scratchpad could use, select() benchmarks both ways
+	// once at startup with the scratchpad traffic in between and sets this flag.
+	static bool table;
+	static void select();
 };
 static_assert(sizeof(SqrtV2) == 8, "SqrtV2 must be 8 bytes in size, check your compiler options");
 
@@ -1,6 +1,5 @@
 #ifndef VARIANT4_RANDOM_MATH_H
 #define VARIANT4_RANDOM_MATH_H
-#include <sys/mman.h>
 extern "C"
 {
     #include "c_blake256.h"
@@ -84,6 +83,9 @@ typedef struct V4_Instruction v4_ins;
 #endif
 #endif
 
+#ifdef XMRIG_PPC64
+#include <stddef.h>
+
 #define D(d)    (d << 21)
 #define S(s)		(s << 21)
 #define A(a)		(a << 16)
@@ -115,7 +117,7 @@ typedef struct V4_Instruction v4_ins;
 #define CLRLWI  (uint32_t)9999
 #define ROTLW (uint32_t)HI(23)
 #define RLWINM_27_31 (uint32_t)9997
-uint32_t gen_op(uint32_t op,uint32_t a0, uint32_t a1, uint32_t a2 ){
+static inline uint32_t gen_op(uint32_t op,uint32_t a0, uint32_t a1, uint32_t a2 ){
   switch (op){
     case(ADD):
       op = ADD | D((uint8_t)a0) | A((uint8_t)a1) | B((uint8_t)a2);
@@ -169,13 +171,12 @@ uint32_t gen_op(uint32_t op,uint32_t a0, uint32_t a1, uint32_t a2 ){
   return op;
 }
 //powerpc code hex
-uint32_t prolog[] = {
+static const uint32_t prolog[] = {
 0x7c0802a6,   //mflr r0 save lr to r0
 0xf8010010,  //std r0 16(r1) save r0 to stack
-0x0000000 //end stream
 };
 
-uint32_t r3_to_reg[] = {
+static const uint32_t r3_to_reg[] = {
 0x80830000,//      lwz 4,0(3)
 0x80A30004,//      lwz 5,4(3)
 0x80C30008,//      lwz 6,8(3)
@@ -185,10 +186,9 @@ uint32_t r3_to_reg[] = {
 0x81430018,//      lwz 10,24(3)
 0x8163001C,//      lwz 11,28(3)
 0x81830020,//      lwz 12,32(3)
-0x00000000
 };
 
-uint32_t reg_to_r3[] = {
+static const uint32_t reg_to_r3[] = {
 0x90830000,//      stw 4,0(3)
 0x90A30004,//      stw 5,4(3)
 0x90C30008,//      stw 6,8(3)
@@ -198,113 +198,370 @@ uint32_t reg_to_r3[] = {
 0x91430018,//      stw 10,24(3)
 0x9163001C,//      stw 11,28(3)
 0x91830020,//      stw 12,32(3)
-0x00000000
 };
 
-uint32_t epilog[] = {
+static const uint32_t epilog[] = {
 0xe8010010 ,  //ld r0,16(r1) load lr from stack to r0
 0x7c0803a6 ,  //restore link register
 0x4e800020, //jump to lr
-0x00000000 //end stream
 };
 
-void* JIT_init() {
-  //allocate exec memory
-  //printf("Started JIT");
-  uint32_t* memory = (uint32_t*)mmap(NULL,             // address
-                      INST_LEN*sizeof(uint32_t),             // size
-                      PROT_READ | PROT_WRITE | PROT_EXEC,
-                      MAP_PRIVATE | MAP_ANONYMOUS,
-                      -1,               // fd (not used here)
-                      0);               // offset (not used here)
-  //printf("Started JIT at %p\n",memory);
-  return (void*)memory;
+//unconditional relative branch, offset in bytes
+#define BR(offset)	(uint32_t)(HI(18) | ((offset) & 0x03fffffc))
+
+//linear code emitter: writes through a cursor and never goes past the end of the buffer,
+//an overflow is sticky and makes the whole program invalid.
+struct JIT_Emitter
+{
+  uint32_t* code;
+  uint32_t pos;
+  uint32_t size;
+  bool overflow;
+};
+
+static inline void JIT_begin(JIT_Emitter* e, void* execmem, uint32_t size){
+  e->code = (uint32_t*)execmem;
+  e->pos = 0;
+  e->size = size;
+  e->overflow = false;
 }
 
-void JIT_load(void* execmem, uint32_t* code){
-  uint32_t idx = 0;
-  uint32_t* inst = (uint32_t*)execmem;
-  for (;idx < INST_LEN; ++idx){
-    if (inst[idx] == 0x00000000){
-      inst = inst+idx;
-      //printf("Currently %d instructions in buffer\n",idx);
-      break;
-    }
+static inline void JIT_emit(JIT_Emitter* e, uint32_t inst){
+  if (e->pos >= e->size){
+    e->overflow = true;
+    return;
   }
-  for (idx = 0; code[idx] != 0x00000000; ++idx){
-    inst[idx] = code[idx];
+  e->code[e->pos++] = inst;
+}
+
+static inline void JIT_emit_block(JIT_Emitter* e, const uint32_t* insts, uint32_t count){
+  if (e->pos + count > e->size){
+    e->overflow = true;
+    return;
   }
+  memcpy(e->code + e->pos, insts, count*sizeof(uint32_t));
+  e->pos += count;
+}
+
+#define JIT_EMIT_ARRAY(e, a) JIT_emit_block(e, a, sizeof(a)/sizeof(a[0]))
 
+//a label is the word index of the next instruction
+static inline uint32_t JIT_label(const JIT_Emitter* e){
+  return e->pos;
 }
-void JIT_end(void* execmem){
-  //printf("Ended JIT at %p\n",execmem);
-  munmap(execmem, INST_LEN*sizeof(uint32_t));
+
+//branch to an already bound label
+static inline void JIT_branch(JIT_Emitter* e, uint32_t label){
+  JIT_emit(e, BR(((int32_t)label - (int32_t)e->pos)*4));
+}
+
+//reserve a branch whose target is not known yet, bind it later with JIT_patch
+static inline uint32_t JIT_branch_fwd(JIT_Emitter* e){
+  const uint32_t at = e->pos;
+  JIT_emit(e, BR(0));
+  return at;
 }
 
-void* JIT_compile_v3(v4_ins* op)
+static inline void JIT_patch(JIT_Emitter* e, uint32_t at, uint32_t label){
+  if (at < e->pos){
+    e->code[at] = BR(((int32_t)label - (int32_t)at)*4);
+  }
+}
+
+//emits the program on the registers in regN, register 0 is kept as tmp register for ROR.
+//C values are encoded directly in immediate add instructions.
+static inline void JIT_random_math(JIT_Emitter* e, const v4_ins* op, const uint8_t* regN)
 {
-  //this function takes only one argument, pointer to data. C values are encoded directly in immediate add instructions.
-  //data is loaded in registers 4,5,6,7,8,9,10,11,12
-  //register 0 is kept as tmp register for ROR.
-  //as of now, this generator is as fast as gcc-8 and clang-9 generated code. 
-  void* f = JIT_init();
-  uint8_t regN[] = {4,5,6,7,8,9,10,11,12};
-  uint8_t r0 = 0;
-  JIT_load(f,prolog);
-  JIT_load(f,r3_to_reg);
+  const uint8_t r0 = 0;
   for (uint32_t i = 0; i < 70; ++i)
 	{ 
-    uint8_t dst = op[i].dst_index;
-    uint8_t src = op[i].src_index;
-    uint32_t tmp[] = {0,0,0,0};
-    int16_t* C;
+    const uint8_t dst = op[i].dst_index;
+    const uint8_t src = op[i].src_index;
+    const int16_t* C;
     switch (op[i].opcode) 
 		{ 
 		case mul_: 
-      tmp[0] = gen_op(MULLW,regN[dst],regN[dst],regN[src]);
-      JIT_load(f,tmp);
+      JIT_emit(e,gen_op(MULLW,regN[dst],regN[dst],regN[src]));
 			break; 
 		case add_:
-      C = (int16_t*)&op[i].C;
-      tmp[0] = gen_op(ADD,regN[dst],regN[dst],regN[src]);
+      C = (const int16_t*)&op[i].C;
+      JIT_emit(e,gen_op(ADD,regN[dst],regN[dst],regN[src]));
       if(C[0] < 0){
-        tmp[1] = gen_op(ADDIS,regN[dst],regN[dst],C[1]+1);
+        JIT_emit(e,gen_op(ADDIS,regN[dst],regN[dst],C[1]+1));
       }else{
-        tmp[1] = gen_op(ADDIS,regN[dst],regN[dst],C[1]);
+        JIT_emit(e,gen_op(ADDIS,regN[dst],regN[dst],C[1]));
       }
-      tmp[2] = gen_op(ADDI,regN[dst],regN[dst],C[0]); 
-      JIT_load(f,tmp);
+      JIT_emit(e,gen_op(ADDI,regN[dst],regN[dst],C[0]));
 			break; 
 		case sub_: 
-      tmp[0] = gen_op(SUBF,regN[dst],regN[src],regN[dst]);
-      JIT_load(f,tmp);
+      JIT_emit(e,gen_op(SUBF,regN[dst],regN[src],regN[dst]));
 			break; 
 		case ror_:
-      tmp[0] = gen_op(NEG,r0,regN[src],0);
-      tmp[1] = gen_op(ROTLW,regN[dst],regN[dst],r0);
-      JIT_load(f,tmp);
+      JIT_emit(e,gen_op(NEG,r0,regN[src],0));
+      JIT_emit(e,gen_op(ROTLW,regN[dst],regN[dst],r0));
 			break; 
 		case rol_: 
-      tmp[0] = gen_op(ROTLW,regN[dst],regN[dst],regN[src]);
-      JIT_load(f,tmp);
+      JIT_emit(e,gen_op(ROTLW,regN[dst],regN[dst],regN[src]));
 			break; 
 		case xor_: 
-      tmp[0] = gen_op(XOR,regN[dst],regN[dst],regN[src]);
-      JIT_load(f,tmp);
+      JIT_emit(e,gen_op(XOR,regN[dst],regN[dst],regN[src]));
 			break; 
 		case RET: 
-      JIT_load(f,reg_to_r3);
-      JIT_load(f,epilog);
-      return f;
-			break; 
+      return;
 		default: 
 			UNREACHABLE_CODE; 
 			break; 
 		}
 	}
-  return f;
 }
 
+//returns the number of emitted words, 0 if the program did not fit in size words
+static inline uint32_t JIT_compile_v3(const v4_ins* op, void* f, uint32_t size)
+{
+  //this function takes only one argument, pointer to data.
+  //data is loaded in registers 4,5,6,7,8,9,10,11,12
+  //as of now, this generator is as fast as gcc-8 and clang-9 generated code. 
+  JIT_Emitter e;
+  JIT_begin(&e, f, size);
+  const uint8_t regN[] = {4,5,6,7,8,9,10,11,12};
+  JIT_EMIT_ARRAY(&e,prolog);
+  JIT_EMIT_ARRAY(&e,r3_to_reg);
+  JIT_random_math(&e, op, regN);
+  JIT_EMIT_ARRAY(&e,reg_to_r3);
+  JIT_EMIT_ARRAY(&e,epilog);
+  return e.overflow ? 0 : e.pos;
+}
+
+//whole CN/R main loop, the generated function is void f(cn_r_loop_state*).
+//everything except AES lives in GPRs for the whole loop, AES is a single vcipher with
+//a zero round key, the real round key (ax) is xored in GPRs afterwards.
+struct cn_r_loop_state
+{
+  uint8_t* memory;
+  uint64_t al;
+  uint64_t ah;
+  uint64_t bx0[2];
+  uint64_t bx1[2];
+  uint32_t r[4];
+  uint64_t mask;
+  uint64_t iterations;
+  uint64_t perm[2]; //vperm control, swaps the bytes of each doubleword
+};
+
+typedef void(*fn_cn_r_mainloop)(cn_r_loop_state*);
+
+static inline void cn_r_loop_state_init(cn_r_loop_state* s){
+  s->perm[0] = 0x0706050403020100ULL;
+  s->perm[1] = 0x0f0e0d0c0b0a0908ULL;
+}
+
+#define JIT_DS(ds)	((uint32_t)(ds) & 0xfffc)
+#define JIT_VX(t)	(((t) & 31) << 21)
+#define JIT_TX(t)	(((t) >> 5) & 1)
+
+static inline uint32_t JIT_ld(uint8_t rt, int16_t ds, uint8_t ra)   { return HI(58) | D(rt) | A(ra) | JIT_DS(ds); }
+static inline uint32_t JIT_std(uint8_t rs, int16_t ds, uint8_t ra)  { return HI(62) | S(rs) | A(ra) | JIT_DS(ds); }
+static inline uint32_t JIT_lwz(uint8_t rt, int16_t d, uint8_t ra)   { return LWZ | D(rt) | A(ra) | IMM(d); }
+static inline uint32_t JIT_ldx(uint8_t rt, uint8_t ra, uint8_t rb)  { return HI(31) | D(rt) | A(ra) | B(rb) | LO(21); }
+static inline uint32_t JIT_stdx(uint8_t rs, uint8_t ra, uint8_t rb) { return HI(31) | S(rs) | A(ra) | B(rb) | LO(149); }
+static inline uint32_t JIT_addi(uint8_t rt, uint8_t ra, int16_t si) { return ADDI | D(rt) | A(ra) | IMM(si); }
+static inline uint32_t JIT_add(uint8_t rt, uint8_t ra, uint8_t rb)  { return ADD | D(rt) | A(ra) | B(rb); }
+static inline uint32_t JIT_and(uint8_t ra, uint8_t rs, uint8_t rb)  { return HI(31) | S(rs) | A(ra) | B(rb) | LO(28); }
+static inline uint32_t JIT_or(uint8_t ra, uint8_t rs, uint8_t rb)   { return OR | S(rs) | A(ra) | B(rb); }
+static inline uint32_t JIT_xor(uint8_t ra, uint8_t rs, uint8_t rb)  { return XOR | S(rs) | A(ra) | B(rb); }
+static inline uint32_t JIT_xori(uint8_t ra, uint8_t rs, uint16_t ui){ return HI(26) | S(rs) | A(ra) | IMM(ui); }
+static inline uint32_t JIT_mr(uint8_t ra, uint8_t rs)               { return JIT_or(ra, rs, rs); }
+static inline uint32_t JIT_mulld(uint8_t rt, uint8_t ra, uint8_t rb) { return HI(31) | D(rt) | A(ra) | B(rb) | LO(233); }
+static inline uint32_t JIT_mulhdu(uint8_t rt, uint8_t ra, uint8_t rb){ return HI(31) | D(rt) | A(ra) | B(rb) | LO(9); }
+//clrldi ra,rs,32 = rldicl ra,rs,0,32
+static inline uint32_t JIT_clrldi32(uint8_t ra, uint8_t rs)         { return HI(30) | S(rs) | A(ra) | (1 << 5); }
+//sldi ra,rs,32 = rldicr ra,rs,32,31
+static inline uint32_t JIT_sldi32(uint8_t ra, uint8_t rs)           { return HI(30) | S(rs) | A(ra) | (31 << 6) | (1 << 2) | (1 << 1); }
+static inline uint32_t JIT_mtctr(uint8_t rs)                        { return HI(31) | S(rs) | (9 << 16) | LO(467); }
+//bdnz to an already bound label
+static inline void JIT_bdnz(JIT_Emitter* e, uint32_t label){
+  JIT_emit(e, HI(16) | (16 << 21) | JIT_DS(((int32_t)label - (int32_t)e->pos)*4));
+}
+//vector instructions take VSR numbers, VR n is VSR 32+n
+static inline uint32_t JIT_lxvd2x(uint8_t xt, uint8_t ra, uint8_t rb){ return HI(31) | JIT_VX(xt) | A(ra) | B(rb) | LO(844) | JIT_TX(xt); }
+static inline uint32_t JIT_mfvsrd(uint8_t ra, uint8_t xs)           { return HI(31) | JIT_VX(xs) | A(ra) | LO(51) | JIT_TX(xs); }
+static inline uint32_t JIT_xxswapd(uint8_t xt, uint8_t xa){
+  return HI(60) | JIT_VX(xt) | (((xa) & 31) << 16) | (((xa) & 31) << 11) | (2 << 8) | (10 << 3) | (JIT_TX(xa) << 2) | (JIT_TX(xa) << 1) | JIT_TX(xt);
+}
+//VR operands
+static inline uint32_t JIT_vperm(uint8_t vt, uint8_t va, uint8_t vb, uint8_t vc) { return HI(4) | D(vt) | A(va) | B(vb) | MC(vc) | 43; }
+static inline uint32_t JIT_vcipher(uint8_t vt, uint8_t va, uint8_t vb) { return HI(4) | D(vt) | A(va) | B(vb) | 1288; }
+static inline uint32_t JIT_vxor(uint8_t vt, uint8_t va, uint8_t vb)    { return HI(4) | D(vt) | A(va) | B(vb) | 1220; }
+
+//shuffle of the three other 16 byte chunks of the 64 byte line at L+off, fold_cx xors the chunks
+//into cx (VARIANT2_SHUFFLE for VARIANT_4), shuffle2 mixes hi/lo in (VARIANT2_SHUFFLE2).
+static inline void JIT_cn_r_shuffle(JIT_Emitter* e, uint8_t off, bool fold_cx, bool shuffle2)
+{
+  //register layout, see JIT_compile_cn_r_mainloop
+  const uint8_t L = 3, L8 = 4, AL = 6, AH = 7, B0L = 8, B0H = 9, B1L = 10, B1H = 11, T = 12;
+  const uint8_t CXL = 14, CXH = 15, HI_ = 20, LO_ = 21;
+  const uint8_t C1L = 22, C1H = 23, C2L = 24, C2H = 25, C3L = 26, C3H = 27;
+
+  JIT_emit(e, JIT_xori(T, off, 0x10));
+  JIT_emit(e, JIT_ldx(C1L, L, T));
+  JIT_emit(e, JIT_ldx(C1H, L8, T));
+  JIT_emit(e, JIT_xori(T, off, 0x20));
+  JIT_emit(e, JIT_ldx(C2L, L, T));
+  JIT_emit(e, JIT_ldx(C2H, L8, T));
+  JIT_emit(e, JIT_xori(T, off, 0x30));
+  JIT_emit(e, JIT_ldx(C3L, L, T));
+  JIT_emit(e, JIT_ldx(C3H, L8, T));
+
+  if (shuffle2) {
+    JIT_emit(e, JIT_xor(C1L, C1L, HI_));
+    JIT_emit(e, JIT_xor(C1H, C1H, LO_));
+    JIT_emit(e, JIT_xor(HI_, HI_, C2L));
+    JIT_emit(e, JIT_xor(LO_, LO_, C2H));
+  }
+
+  JIT_emit(e, JIT_xori(T, off, 0x10));
+  JIT_emit(e, JIT_add(0, C3L, B1L));
+  JIT_emit(e, JIT_stdx(0, L, T));
+  JIT_emit(e, JIT_add(0, C3H, B1H));
+  JIT_emit(e, JIT_stdx(0, L8, T));
+  JIT_emit(e, JIT_xori(T, off, 0x20));
+  JIT_emit(e, JIT_add(0, C1L, B0L));
+  JIT_emit(e, JIT_stdx(0, L, T));
+  JIT_emit(e, JIT_add(0, C1H, B0H));
+  JIT_emit(e, JIT_stdx(0, L8, T));
+  JIT_emit(e, JIT_xori(T, off, 0x30));
+  JIT_emit(e, JIT_add(0, C2L, AL));
+  JIT_emit(e, JIT_stdx(0, L, T));
+  JIT_emit(e, JIT_add(0, C2H, AH));
+  JIT_emit(e, JIT_stdx(0, L8, T));
+
+  if (fold_cx) {
+    JIT_emit(e, JIT_xor(CXL, CXL, C1L));
+    JIT_emit(e, JIT_xor(CXH, CXH, C1H));
+    JIT_emit(e, JIT_xor(CXL, CXL, C2L));
+    JIT_emit(e, JIT_xor(CXH, CXH, C2H));
+    JIT_emit(e, JIT_xor(CXL, CXL, C3L));
+    JIT_emit(e, JIT_xor(CXH, CXH, C3H));
+  }
+}
+
+//returns the number of emitted words, 0 if the loop did not fit in size words.
+//wow selects VARIANT_WOW semantics, otherwise VARIANT_4.
+static inline uint32_t JIT_compile_cn_r_mainloop(const v4_ins* op, bool wow, void* f, uint32_t size)
+{
+  //r3 L (scratchpad), r4 L+8, r5 mask, r6/r7 al/ah, r8/r9 bx0, r10/r11 bx1, r12 and r0 tmp,
+  //r14/r15 cx, r16/r17 offsets, r18/r19 cl/ch, r20/r21 hi/lo, r22-r27 shuffle chunks,
+  //r28-r31 random math r0-r3, r4-r8 of the random math are read straight from al, ah, bx0, bx1.
+  //v0 byte swap control, v1 zero, v2/v3 tmp. The loop counter is CTR.
+  //this is a leaf function, the non-volatile GPRs are saved in the ELFv2 red zone.
+  const uint8_t ST = 3, L = 3, L8 = 4, MASK = 5, AL = 6, AH = 7, B0L = 8, B0H = 9, B1L = 10, B1H = 11, T = 12;
+  const uint8_t CXL = 14, CXH = 15, OFF = 16, OFF2 = 17, CL = 18, CH = 19, HI_ = 20, LO_ = 21;
+  const uint8_t R0 = 28, R1 = 29, R2 = 30, R3 = 31;
+  const uint8_t VPERM = 0, VZERO = 1, VT = 2, VT2 = 3;
+  const uint8_t regN[] = {R0, R1, R2, R3, AL, AH, B0L, B1L, B1H};
+
+  JIT_Emitter e;
+  JIT_begin(&e, f, size);
+
+  for (uint8_t r = 14; r < 32; ++r) {
+    JIT_emit(&e, JIT_std(r, -8 * (32 - r), 1));
+  }
+
+  JIT_emit(&e, JIT_addi(0, 0, offsetof(cn_r_loop_state, perm)));
+  JIT_emit(&e, JIT_lxvd2x(32 + VPERM, ST, 0));
+  JIT_emit(&e, JIT_vxor(VZERO, VZERO, VZERO));
+  JIT_emit(&e, JIT_ld(AL,  offsetof(cn_r_loop_state, al), ST));
+  JIT_emit(&e, JIT_ld(AH,  offsetof(cn_r_loop_state, ah), ST));
+  JIT_emit(&e, JIT_ld(B0L, offsetof(cn_r_loop_state, bx0), ST));
+  JIT_emit(&e, JIT_ld(B0H, offsetof(cn_r_loop_state, bx0) + 8, ST));
+  JIT_emit(&e, JIT_ld(B1L, offsetof(cn_r_loop_state, bx1), ST));
+  JIT_emit(&e, JIT_ld(B1H, offsetof(cn_r_loop_state, bx1) + 8, ST));
+  JIT_emit(&e, JIT_lwz(R0, offsetof(cn_r_loop_state, r), ST));
+  JIT_emit(&e, JIT_lwz(R1, offsetof(cn_r_loop_state, r) + 4, ST));
+  JIT_emit(&e, JIT_lwz(R2, offsetof(cn_r_loop_state, r) + 8, ST));
+  JIT_emit(&e, JIT_lwz(R3, offsetof(cn_r_loop_state, r) + 12, ST));
+  JIT_emit(&e, JIT_ld(MASK, offsetof(cn_r_loop_state, mask), ST));
+  JIT_emit(&e, JIT_ld(T, offsetof(cn_r_loop_state, iterations), ST));
+  JIT_emit(&e, JIT_mtctr(T));
+  JIT_emit(&e, JIT_ld(L, offsetof(cn_r_loop_state, memory), ST));
+  JIT_emit(&e, JIT_addi(L8, L, 8));
+
+  const uint32_t loop = JIT_label(&e);
+
+  //cx = aesenc(l[al & mask], ax), lxvd2x leaves both doublewords as native integers,
+  //vcipher wants the AES state in memory byte order.
+  JIT_emit(&e, JIT_and(OFF, AL, MASK));
+  JIT_emit(&e, JIT_lxvd2x(32 + VT, L, OFF));
+  JIT_emit(&e, JIT_vperm(VT, VT, VT, VPERM));
+  JIT_emit(&e, JIT_vcipher(VT, VT, VZERO));
+  JIT_emit(&e, JIT_vperm(VT, VT, VT, VPERM));
+  JIT_emit(&e, JIT_mfvsrd(CXL, 32 + VT));
+  JIT_emit(&e, JIT_xxswapd(32 + VT2, 32 + VT));
+  JIT_emit(&e, JIT_mfvsrd(CXH, 32 + VT2));
+  JIT_emit(&e, JIT_xor(CXL, CXL, AL));
+  JIT_emit(&e, JIT_xor(CXH, CXH, AH));
+
+  JIT_cn_r_shuffle(&e, OFF, !wow, false);
+
+  JIT_emit(&e, JIT_xor(T, B0L, CXL));
+  JIT_emit(&e, JIT_stdx(T, L, OFF));
+  JIT_emit(&e, JIT_xor(T, B0H, CXH));
+  JIT_emit(&e, JIT_stdx(T, L8, OFF));
+
+  JIT_emit(&e, JIT_and(OFF2, CXL, MASK));
+  JIT_emit(&e, JIT_ldx(CL, L, OFF2));
+  JIT_emit(&e, JIT_ldx(CH, L8, OFF2));
+
+  //cl ^= (r0 + r1) | ((r2 + r3) << 32)
+  JIT_emit(&e, JIT_add(T, R0, R1));
+  JIT_emit(&e, JIT_clrldi32(T, T));
+  JIT_emit(&e, JIT_add(0, R2, R3));
+  JIT_emit(&e, JIT_sldi32(0, 0));
+  JIT_emit(&e, JIT_or(T, T, 0));
+  JIT_emit(&e, JIT_xor(CL, CL, T));
+
+  JIT_random_math(&e, op, regN);
+
+  JIT_emit(&e, JIT_mulhdu(HI_, CXL, CL));
+  JIT_emit(&e, JIT_mulld(LO_, CXL, CL));
+
+  JIT_cn_r_shuffle(&e, OFF2, !wow, wow);
+
+  if (!wow) {
+    //al ^= r2 | (r3 << 32), ah ^= r0 | (r1 << 32), done after the shuffle because it needs the old ax
+    JIT_emit(&e, JIT_clrldi32(T, R2));
+    JIT_emit(&e, JIT_sldi32(0, R3));
+    JIT_emit(&e, JIT_or(T, T, 0));
+    JIT_emit(&e, JIT_xor(AL, AL, T));
+    JIT_emit(&e, JIT_clrldi32(T, R0));
+    JIT_emit(&e, JIT_sldi32(0, R1));
+    JIT_emit(&e, JIT_or(T, T, 0));
+    JIT_emit(&e, JIT_xor(AH, AH, T));
+  }
+
+  JIT_emit(&e, JIT_add(AL, AL, HI_));
+  JIT_emit(&e, JIT_add(AH, AH, LO_));
+  JIT_emit(&e, JIT_stdx(AL, L, OFF2));
+  JIT_emit(&e, JIT_stdx(AH, L8, OFF2));
+  JIT_emit(&e, JIT_xor(AL, AL, CL));
+  JIT_emit(&e, JIT_xor(AH, AH, CH));
+
+  JIT_emit(&e, JIT_mr(B1L, B0L));
+  JIT_emit(&e, JIT_mr(B1H, B0H));
+  JIT_emit(&e, JIT_mr(B0L, CXL));
+  JIT_emit(&e, JIT_mr(B0H, CXH));
+
+  JIT_bdnz(&e, loop);
+
+  for (uint8_t r = 14; r < 32; ++r) {
+    JIT_emit(&e, JIT_ld(r, -8 * (32 - r), 1));
+  }
+  JIT_emit(&e, 0x4e800020); //blr
+
+  return e.overflow ? 0 : e.pos;
+}
+#endif /* XMRIG_PPC64 */
+
 
 // Random math interpreter's loop is fully unrolled and inlined to achieve 100% branch prediction on CPU:
 // every switch-case will point to the same destination on every iteration of Cryptonight main loop
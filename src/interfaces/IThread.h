@@ -48,7 +48,9 @@ public:
         DoubleWay,
         TripleWay,
         QuadWay,
-        PentaWay
+        PentaWay,
+        OctaWay     = 8,
+        HexadecaWay = 16
     };
 
     virtual ~IThread() {}
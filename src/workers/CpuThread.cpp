@@ -22,6 +22,7 @@
  *   along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <assert.h>
 
 
@@ -35,15 +36,23 @@
 
 #if defined(XMRIG_ARM)
 #   include "crypto/CryptoNight_arm.h"
-#else
+#elif defined(XMRIG_PPC64)
 #   include "crypto/CryptoNight_ppc64.h"
+#   define XMRIG_CN_MULTI_HASH
+#elif !defined(XMRIG_REF)
+#   include "crypto/CryptoNight_x86.h"
+#   define XMRIG_CN_MULTI_HASH
+#   define XMRIG_CN_PIPELINE
 #endif
 
+#include "crypto/CryptoNight_ref.h"
 
-xmrig::CpuThread::CpuThread(size_t index, Algo algorithm, AlgoVariant av, Multiway multiway, int64_t affinity, int priority, bool softAES, bool prefetch, Assembly assembly) :
+
+xmrig::CpuThread::CpuThread(size_t index, Algo algorithm, AlgoVariant av, Multiway multiway, int64_t affinity, int priority, bool softAES, bool prefetch, Assembly assembly, bool pipeline) :
     m_algorithm(algorithm),
     m_av(av),
     m_assembly(assembly),
+    m_pipeline(pipeline),
     m_prefetch(prefetch),
     m_softAES(softAES),
     m_priority(priority),
@@ -170,7 +179,99 @@ void xmrig::CpuThread::patchAsmVariants()
 
 bool xmrig::CpuThread::isSoftAES(AlgoVariant av)
 {
-    return av == AV_SINGLE_SOFT || av == AV_DOUBLE_SOFT || av > AV_PENTA;
+    return av == AV_SINGLE_SOFT || av == AV_DOUBLE_SOFT || (av > AV_PENTA && av < AV_OCTA) || av >= AV_OCTA_SOFT;
+}
+
+
+#ifdef XMRIG_CN_MULTI_HASH
+template<xmrig::Algo algo, xmrig::Variant variant>
+static inline void add_multi_func(xmrig::CpuThread::cn_hash_fun(&multi_func_map)[xmrig::ALGO_MAX][xmrig::AV_MAX - xmrig::AV_OCTA][xmrig::VARIANT_MAX])
+{
+    multi_func_map[algo][xmrig::AV_OCTA - xmrig::AV_OCTA][variant]          = cryptonight_multi_hash<algo, false, variant, 8>;
+    multi_func_map[algo][xmrig::AV_HEXADECA - xmrig::AV_OCTA][variant]      = cryptonight_multi_hash<algo, false, variant, 16>;
+    multi_func_map[algo][xmrig::AV_OCTA_SOFT - xmrig::AV_OCTA][variant]     = cryptonight_multi_hash<algo, true,  variant, 8>;
+    multi_func_map[algo][xmrig::AV_HEXADECA_SOFT - xmrig::AV_OCTA][variant] = cryptonight_multi_hash<algo, true,  variant, 16>;
+}
+#endif
+
+
+static xmrig::CpuThread::cn_hash_fun multi_hash_fn(xmrig::Algo algorithm, xmrig::AlgoVariant av, xmrig::Variant variant)
+{
+    using namespace xmrig;
+
+#   ifdef XMRIG_CN_MULTI_HASH
+    // Reached from fn() for every batch of every worker thread, a magic static makes the first fill thread safe.
+    struct Table { CpuThread::cn_hash_fun fun[ALGO_MAX][AV_MAX - AV_OCTA][VARIANT_MAX]; };
+    static const Table multi_func_map = [] {
+        Table table = {};
+
+#       ifndef XMRIG_NO_AEON
+        add_multi_func<CRYPTONIGHT_LITE, VARIANT_0>(table.fun);
+        add_multi_func<CRYPTONIGHT_LITE, VARIANT_1>(table.fun);
+#       endif
+
+#       ifndef XMRIG_NO_CN_PICO
+        add_multi_func<CRYPTONIGHT_PICO, VARIANT_TRTL>(table.fun);
+#       endif
+
+        return table;
+    }();
+
+    return multi_func_map.fun[algorithm][av - AV_OCTA][variant];
+#   else
+    return nullptr;
+#   endif
+}
+
+
+template<xmrig::Algo algo, xmrig::Variant variant>
+static inline void add_ref_func(xmrig::CpuThread::cn_hash_fun(&ref_func_map)[xmrig::ALGO_MAX][xmrig::VARIANT_MAX])
+{
+    ref_func_map[algo][variant] = cryptonight_ref_multi_hash<algo, variant, 1>;
+}
+
+
+static xmrig::CpuThread::cn_hash_fun ref_hash_fn(xmrig::Algo algorithm, xmrig::Variant variant)
+{
+    using namespace xmrig;
+
+    struct Table { CpuThread::cn_hash_fun fun[ALGO_MAX][VARIANT_MAX]; };
+    static const Table ref_func_map = [] {
+        Table table = {};
+
+        add_ref_func<CRYPTONIGHT, VARIANT_0>(table.fun);
+        add_ref_func<CRYPTONIGHT, VARIANT_1>(table.fun);
+        add_ref_func<CRYPTONIGHT, VARIANT_XTL>(table.fun);
+        add_ref_func<CRYPTONIGHT, VARIANT_MSR>(table.fun);
+        add_ref_func<CRYPTONIGHT, VARIANT_XAO>(table.fun);
+        add_ref_func<CRYPTONIGHT, VARIANT_RTO>(table.fun);
+        add_ref_func<CRYPTONIGHT, VARIANT_2>(table.fun);
+        add_ref_func<CRYPTONIGHT, VARIANT_HALF>(table.fun);
+        add_ref_func<CRYPTONIGHT, VARIANT_WOW>(table.fun);
+        add_ref_func<CRYPTONIGHT, VARIANT_4>(table.fun);
+        add_ref_func<CRYPTONIGHT, VARIANT_RWZ>(table.fun);
+        add_ref_func<CRYPTONIGHT, VARIANT_ZLS>(table.fun);
+        add_ref_func<CRYPTONIGHT, VARIANT_DOUBLE>(table.fun);
+
+#       ifndef XMRIG_NO_AEON
+        add_ref_func<CRYPTONIGHT_LITE, VARIANT_0>(table.fun);
+        add_ref_func<CRYPTONIGHT_LITE, VARIANT_1>(table.fun);
+#       endif
+
+#       ifndef XMRIG_NO_SUMO
+        add_ref_func<CRYPTONIGHT_HEAVY, VARIANT_0>(table.fun);
+        add_ref_func<CRYPTONIGHT_HEAVY, VARIANT_XHV>(table.fun);
+        add_ref_func<CRYPTONIGHT_HEAVY, VARIANT_TUBE>(table.fun);
+#       endif
+
+#       ifndef XMRIG_NO_CN_PICO
+        add_ref_func<CRYPTONIGHT_PICO, VARIANT_TRTL>(table.fun);
+#       endif
+
+        return table;
+    }();
+
+    return ref_func_map.fun[algorithm][variant];
 }
 
 
@@ -197,32 +298,40 @@ xmrig::CpuThread::cn_hash_fun xmrig::CpuThread::fn(Algo algorithm, AlgoVariant a
         assembly = Cpu::info()->assembly();
     }
 
-    static cn_hash_fun asm_func_map[ALGO_MAX][AV_MAX][VARIANT_MAX][ASM_MAX] = {};
-    static bool asm_func_map_initialized = false;
+    struct Table { cn_hash_fun fun[ALGO_MAX][AV_MAX][VARIANT_MAX][ASM_MAX]; };
+    static const Table asm_func_map = [] {
+        Table table = {};
 
-    if (!asm_func_map_initialized) {
-        add_asm_func<CRYPTONIGHT, VARIANT_2>(asm_func_map);
-        add_asm_func<CRYPTONIGHT, VARIANT_HALF>(asm_func_map);
-        add_asm_func<CRYPTONIGHT, VARIANT_WOW>(asm_func_map);
-        add_asm_func<CRYPTONIGHT, VARIANT_4>(asm_func_map);
+        add_asm_func<CRYPTONIGHT, VARIANT_2>(table.fun);
+        add_asm_func<CRYPTONIGHT, VARIANT_HALF>(table.fun);
+        add_asm_func<CRYPTONIGHT, VARIANT_WOW>(table.fun);
+        add_asm_func<CRYPTONIGHT, VARIANT_4>(table.fun);
 
 #       ifndef XMRIG_NO_CN_PICO
-        add_asm_func<CRYPTONIGHT_PICO, VARIANT_TRTL>(asm_func_map);
+        add_asm_func<CRYPTONIGHT_PICO, VARIANT_TRTL>(table.fun);
 #       endif
 
-        add_asm_func<CRYPTONIGHT, VARIANT_RWZ>(asm_func_map);
-        add_asm_func<CRYPTONIGHT, VARIANT_ZLS>(asm_func_map);
-        add_asm_func<CRYPTONIGHT, VARIANT_DOUBLE>(asm_func_map);
+        add_asm_func<CRYPTONIGHT, VARIANT_RWZ>(table.fun);
+        add_asm_func<CRYPTONIGHT, VARIANT_ZLS>(table.fun);
+        add_asm_func<CRYPTONIGHT, VARIANT_DOUBLE>(table.fun);
 
-        asm_func_map_initialized = true;
-    }
+        return table;
+    }();
 
-    cn_hash_fun fun = asm_func_map[algorithm][av][variant][assembly];
+    cn_hash_fun fun = asm_func_map.fun[algorithm][av][variant][assembly];
     if (fun) {
         return fun;
     }
 #   endif
 
+    if (av == AV_REF) {
+        return ref_hash_fn(algorithm, variant);
+    }
+
+    if (av >= AV_OCTA) {
+        return multi_hash_fn(algorithm, av, variant);
+    }
+
     constexpr const size_t count = VARIANT_MAX * 10 * ALGO_MAX;
 
     static const cn_hash_fun func_table[] = {
@@ -585,6 +694,85 @@ xmrig::CpuThread::cn_hash_fun xmrig::CpuThread::fn(Algo algorithm, AlgoVariant a
 }
 
 
+#ifdef XMRIG_CN_PIPELINE
+template<xmrig::Algo algo, xmrig::Variant variant>
+static inline void add_pipelined_func(xmrig::CpuThread::cn_hash_fun(&pipelined_func_map)[xmrig::ALGO_MAX][2][xmrig::VARIANT_MAX][xmrig::IThread::PentaWay + 1])
+{
+    pipelined_func_map[algo][0][variant][xmrig::IThread::DoubleWay] = cryptonight_pipelined_hash<algo, false, variant, 2>;
+    pipelined_func_map[algo][0][variant][xmrig::IThread::TripleWay] = cryptonight_pipelined_hash<algo, false, variant, 3>;
+    pipelined_func_map[algo][0][variant][xmrig::IThread::QuadWay]   = cryptonight_pipelined_hash<algo, false, variant, 4>;
+    pipelined_func_map[algo][0][variant][xmrig::IThread::PentaWay]  = cryptonight_pipelined_hash<algo, false, variant, 5>;
+
+    pipelined_func_map[algo][1][variant][xmrig::IThread::DoubleWay] = cryptonight_pipelined_hash<algo, true,  variant, 2>;
+    pipelined_func_map[algo][1][variant][xmrig::IThread::TripleWay] = cryptonight_pipelined_hash<algo, true,  variant, 3>;
+    pipelined_func_map[algo][1][variant][xmrig::IThread::QuadWay]   = cryptonight_pipelined_hash<algo, true,  variant, 4>;
+    pipelined_func_map[algo][1][variant][xmrig::IThread::PentaWay]  = cryptonight_pipelined_hash<algo, true,  variant, 5>;
+}
+#endif
+
+
+xmrig::CpuThread::cn_hash_fun xmrig::CpuThread::pipelinedFn(Algo algorithm, Multiway multiway, bool softAES, Variant variant)
+{
+    assert(variant >= VARIANT_0 && variant < VARIANT_MAX);
+
+#   ifdef XMRIG_CN_PIPELINE
+    // Reached from fn() for every batch of every worker thread, a magic static makes the first fill thread safe.
+    struct Table { cn_hash_fun fun[ALGO_MAX][2][VARIANT_MAX][PentaWay + 1]; };
+    static const Table pipelined_func_map = [] {
+        Table table = {};
+
+        add_pipelined_func<CRYPTONIGHT, VARIANT_0>(table.fun);
+        add_pipelined_func<CRYPTONIGHT, VARIANT_1>(table.fun);
+        add_pipelined_func<CRYPTONIGHT, VARIANT_XTL>(table.fun);
+        add_pipelined_func<CRYPTONIGHT, VARIANT_MSR>(table.fun);
+        add_pipelined_func<CRYPTONIGHT, VARIANT_XAO>(table.fun);
+        add_pipelined_func<CRYPTONIGHT, VARIANT_RTO>(table.fun);
+        add_pipelined_func<CRYPTONIGHT, VARIANT_2>(table.fun);
+        add_pipelined_func<CRYPTONIGHT, VARIANT_HALF>(table.fun);
+        // No cn/wow and cn/r, the pipelined main loop could only run their random math in the interpreter,
+        // which is slower than the generated code of the regular kernels that fn() falls back to.
+        add_pipelined_func<CRYPTONIGHT, VARIANT_RWZ>(table.fun);
+        add_pipelined_func<CRYPTONIGHT, VARIANT_ZLS>(table.fun);
+        add_pipelined_func<CRYPTONIGHT, VARIANT_DOUBLE>(table.fun);
+
+#       ifndef XMRIG_NO_AEON
+        add_pipelined_func<CRYPTONIGHT_LITE, VARIANT_0>(table.fun);
+        add_pipelined_func<CRYPTONIGHT_LITE, VARIANT_1>(table.fun);
+#       endif
+
+#       ifndef XMRIG_NO_SUMO
+        add_pipelined_func<CRYPTONIGHT_HEAVY, VARIANT_0>(table.fun);
+        add_pipelined_func<CRYPTONIGHT_HEAVY, VARIANT_XHV>(table.fun);
+        add_pipelined_func<CRYPTONIGHT_HEAVY, VARIANT_TUBE>(table.fun);
+#       endif
+
+#       ifndef XMRIG_NO_CN_PICO
+        add_pipelined_func<CRYPTONIGHT_PICO, VARIANT_TRTL>(table.fun);
+#       endif
+
+        return table;
+    }();
+
+    return multiway <= PentaWay ? pipelined_func_map.fun[algorithm][softAES ? 1 : 0][variant][multiway] : nullptr;
+#   else
+    return nullptr;
+#   endif
+}
+
+
+xmrig::CpuThread::cn_hash_fun xmrig::CpuThread::fn(Algo algorithm, Variant variant) const
+{
+    if (m_pipeline) {
+        cn_hash_fun fun = pipelinedFn(algorithm, m_multiway, m_softAES, variant);
+        if (fun) {
+            return fun;
+        }
+    }
+
+    return fn(algorithm, m_av, variant, m_assembly);
+}
+
+
 xmrig::CpuThread *xmrig::CpuThread::createFromAV(size_t index, Algo algorithm, AlgoVariant av, int64_t affinity, int priority, Assembly assembly)
 {
     assert(av > AV_AUTO && av < AV_MAX);
@@ -615,18 +803,22 @@ xmrig::CpuThread *xmrig::CpuThread::createFromAV(size_t index, Algo algorithm, A
 xmrig::CpuThread *xmrig::CpuThread::createFromData(size_t index, Algo algorithm, const CpuThread::Data &data, int priority, bool softAES)
 {
     int av                  = AV_AUTO;
-    const Multiway multiway = data.multiway;
+    const Multiway multiway = std::min(data.multiway, maxMultiway(algorithm));
 
     if (multiway <= DoubleWay) {
         av = softAES ? (multiway + 2) : multiway;
     }
-    else {
+    else if (multiway <= PentaWay) {
         av = softAES ? (multiway + 5) : (multiway + 2);
     }
+    else {
+        av = multiway == OctaWay ? AV_OCTA : AV_HEXADECA;
+        av = softAES ? (av + 2) : av;
+    }
 
     assert(av > AV_AUTO && av < AV_MAX);
 
-    return new CpuThread(index, algorithm, static_cast<AlgoVariant>(av), multiway, data.affinity, priority, softAES, false, data.assembly);
+    return new CpuThread(index, algorithm, static_cast<AlgoVariant>(av), multiway, data.affinity, priority, softAES, false, data.assembly, data.pipeline);
 }
 
 
@@ -656,10 +848,27 @@ xmrig::CpuThread::Data xmrig::CpuThread::parse(const rapidjson::Value &object)
     data.assembly = Asm::parse(object["asm"]);
 #   endif
 
+    const auto &pipeline = object["pipeline"];
+    if (pipeline.IsBool()) {
+        data.pipeline = pipeline.GetBool();
+    }
+
     return data;
 }
 
 
+xmrig::IThread::Multiway xmrig::CpuThread::maxMultiway(Algo algorithm)
+{
+#   ifdef XMRIG_CN_MULTI_HASH
+    if (algorithm == CRYPTONIGHT_LITE || algorithm == CRYPTONIGHT_PICO) {
+        return HexadecaWay;
+    }
+#   endif
+
+    return PentaWay;
+}
+
+
 xmrig::IThread::Multiway xmrig::CpuThread::multiway(AlgoVariant av)
 {
     switch (av) {
@@ -683,6 +892,14 @@ xmrig::IThread::Multiway xmrig::CpuThread::multiway(AlgoVariant av)
     case AV_PENTA:
         return PentaWay;
 
+    case AV_OCTA_SOFT:
+    case AV_OCTA:
+        return OctaWay;
+
+    case AV_HEXADECA_SOFT:
+    case AV_HEXADECA:
+        return HexadecaWay;
+
     default:
         break;
     }
@@ -694,8 +911,8 @@ xmrig::IThread::Multiway xmrig::CpuThread::multiway(AlgoVariant av)
 #ifdef APP_DEBUG
 void xmrig::CpuThread::print() const
 {
-    LOG_DEBUG(GREEN_BOLD("CPU thread:   ") " index " WHITE_BOLD("%zu") ", multiway " WHITE_BOLD("%d") ", av " WHITE_BOLD("%d") ",",
-              index(), static_cast<int>(multiway()), static_cast<int>(m_av));
+    LOG_DEBUG(GREEN_BOLD("CPU thread:   ") " index " WHITE_BOLD("%zu") ", multiway " WHITE_BOLD("%d") ", av " WHITE_BOLD("%d") ", pipeline " WHITE_BOLD("%d") ",",
+              index(), static_cast<int>(multiway()), static_cast<int>(m_av), static_cast<int>(isPipeline()));
 
 #   ifndef XMRIG_NO_ASM
     LOG_DEBUG("               assembly: %s, affine_to_cpu: %" PRId64, Asm::toString(m_assembly), affinity());
@@ -720,6 +937,7 @@ rapidjson::Value xmrig::CpuThread::toAPI(rapidjson::Document &doc) const
     obj.AddMember("affine_to_cpu",  affinity(), allocator);
     obj.AddMember("priority",       priority(), allocator);
     obj.AddMember("soft_aes",       isSoftAES(), allocator);
+    obj.AddMember("pipeline",       isPipeline(), allocator);
 
     return obj;
 }
@@ -740,5 +958,9 @@ rapidjson::Value xmrig::CpuThread::toConfig(rapidjson::Document &doc) const
     obj.AddMember("asm", Asm::toJSON(m_assembly), allocator);
 #   endif
 
+    if (isPipeline()) {
+        obj.AddMember("pipeline", true, allocator);
+    }
+
     return obj;
 }
@@ -41,24 +41,25 @@ class CpuThread : public IThread
 public:
     struct Data
     {
-        inline Data() : assembly(ASM_AUTO), valid(false), affinity(-1L), multiway(SingleWay) {}
+        inline Data() : assembly(ASM_AUTO), pipeline(false), valid(false), affinity(-1L), multiway(SingleWay) {}
 
         inline void setMultiway(int value)
         {
-            if (value >= SingleWay && value <= PentaWay) {
+            if ((value >= SingleWay && value <= PentaWay) || value == OctaWay || value == HexadecaWay) {
                 multiway = static_cast<Multiway>(value);
                 valid    = true;
             }
         }
 
         Assembly assembly;
+        bool pipeline;
         bool valid;
         int64_t affinity;
         Multiway multiway;
     };
 
 
-    CpuThread(size_t index, Algo algorithm, AlgoVariant av, Multiway multiway, int64_t affinity, int priority, bool softAES, bool prefetch, Assembly assembly);
+    CpuThread(size_t index, Algo algorithm, AlgoVariant av, Multiway multiway, int64_t affinity, int priority, bool softAES, bool prefetch, Assembly assembly, bool pipeline = false);
 
     typedef void (*cn_hash_fun)(const uint8_t *input, size_t size, uint8_t *output, cryptonight_ctx **ctx, uint64_t height);
     typedef void (*cn_mainloop_fun)(cryptonight_ctx *ctx);
@@ -70,14 +71,19 @@ public:
 
     static bool isSoftAES(AlgoVariant av);
     static cn_hash_fun fn(Algo algorithm, AlgoVariant av, Variant variant, Assembly assembly);
+    static cn_hash_fun pipelinedFn(Algo algorithm, Multiway multiway, bool softAES, Variant variant);
     static CpuThread *createFromAV(size_t index, Algo algorithm, AlgoVariant av, int64_t affinity, int priority, Assembly assembly);
     static CpuThread *createFromData(size_t index, Algo algorithm, const CpuThread::Data &data, int priority, bool softAES);
     static Data parse(const rapidjson::Value &object);
+    static Multiway maxMultiway(Algo algorithm);
     static Multiway multiway(AlgoVariant av);
 
+    cn_hash_fun fn(Algo algorithm, Variant variant) const;
+
+    inline bool isPipeline() const               { return m_pipeline; }
     inline bool isPrefetch() const               { return m_prefetch; }
     inline bool isSoftAES() const                { return m_softAES; }
-    inline cn_hash_fun fn(Variant variant) const { return fn(m_algorithm, m_av, variant, m_assembly); }
+    inline cn_hash_fun fn(Variant variant) const { return fn(m_algorithm, variant); }
 
     inline Algo algorithm() const override       { return m_algorithm; }
     inline int priority() const override         { return m_priority; }
@@ -101,6 +107,7 @@ private:
     const Algo m_algorithm;
     const AlgoVariant m_av;
     const Assembly m_assembly;
+    const bool m_pipeline;
     const bool m_prefetch;
     const bool m_softAES;
     const int m_priority;
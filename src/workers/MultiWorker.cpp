@@ -24,9 +24,12 @@
  */
 
 
+#include <algorithm>
 #include <thread>
 
 
+#include "crypto/CryptoNight.h"
+#include "crypto/CryptoNight_constants.h"
 #include "crypto/CryptoNight_test.h"
 #include "common/log/Log.h"
 #include "workers/CpuThread.h"
@@ -34,11 +37,22 @@
 #include "workers/Workers.h"
 
 
+static constexpr const size_t kTestLanes = sizeof(test_input) / 76;
+
+
 template<size_t N>
 MultiWorker<N>::MultiWorker(Handle *handle)
-    : Worker(handle)
+    : Worker(handle),
+      m_algorithm(m_thread->algorithm()),
+      m_rounds(0)
 {
-    m_memory = Mem::create(m_ctx, m_thread->algorithm(), N);
+    // Sized for the largest algorithm the pool may switch to, switching only re-carves the contexts.
+    size_t memory = 0;
+    for (xmrig::Algo algorithm : Workers::switchAlgorithms()) {
+        memory = std::max(memory, xmrig::cn_select_memory(algorithm));
+    }
+
+    m_memory = Mem::create(m_ctx, m_algorithm, N, memory);
 }
 
 
@@ -51,10 +65,27 @@ MultiWorker<N>::~MultiWorker()
 
 template<size_t N>
 bool MultiWorker<N>::selfTest()
+{
+    for (xmrig::Algo algorithm : Workers::switchAlgorithms()) {
+        if (!selfTest(algorithm)) {
+            return false;
+        }
+    }
+
+    return selfTest(m_thread->algorithm());
+}
+
+
+template<size_t N>
+bool MultiWorker<N>::selfTest(xmrig::Algo algorithm)
 {
     using namespace xmrig;
 
-    if (m_thread->algorithm() == CRYPTONIGHT) {
+    if (!setAlgorithm(algorithm)) {
+        return false;
+    }
+
+    if (algorithm == CRYPTONIGHT) {
         const bool rc = verify(VARIANT_0,      test_output_v0)   &&
                         verify(VARIANT_1,      test_output_v1)   &&
                         verify(VARIANT_2,      test_output_v2)   &&
@@ -80,14 +111,14 @@ bool MultiWorker<N>::selfTest()
     }
 
 #   ifndef XMRIG_NO_AEON
-    if (m_thread->algorithm() == CRYPTONIGHT_LITE) {
+    if (algorithm == CRYPTONIGHT_LITE) {
         return verify(VARIANT_0,    test_output_v0_lite) &&
                verify(VARIANT_1,    test_output_v1_lite);
     }
 #   endif
 
 #   ifndef XMRIG_NO_SUMO
-    if (m_thread->algorithm() == CRYPTONIGHT_HEAVY) {
+    if (algorithm == CRYPTONIGHT_HEAVY) {
         return verify(VARIANT_0,    test_output_v0_heavy)  &&
                verify(VARIANT_XHV,  test_output_xhv_heavy) &&
                verify(VARIANT_TUBE, test_output_tube_heavy);
@@ -95,7 +126,7 @@ bool MultiWorker<N>::selfTest()
 #   endif
 
 #   ifndef XMRIG_NO_CN_PICO
-    if (m_thread->algorithm() == CRYPTONIGHT_PICO) {
+    if (algorithm == CRYPTONIGHT_PICO) {
         return verify(VARIANT_TRTL, test_output_pico_trtl);
     }
 #   endif
@@ -109,10 +140,7 @@ void MultiWorker<N>::start()
 {
     while (Workers::sequence() > 0) {
         if (Workers::isPaused()) {
-            do {
-                std::this_thread::sleep_for(std::chrono::milliseconds(200));
-            }
-            while (Workers::isPaused());
+            Workers::park();
 
             if (Workers::sequence() == 0) {
                 break;
@@ -126,7 +154,17 @@ void MultiWorker<N>::start()
                 storeStats();
             }
 
-            m_thread->fn(m_state.job.algorithm().variant())(m_state.blob, m_state.job.size(), m_hash, m_ctx, m_state.job.height());
+            if (m_algorithm != m_state.job.algorithm().algo()) {
+                Workers::park(m_sequence);
+                continue;
+            }
+
+            m_thread->fn(m_algorithm, m_state.job.algorithm().variant())(m_state.blob, m_state.job.size(), m_hash, m_ctx, m_state.job.height());
+
+            // The kernels cut the batch short when the job changed, m_hash is not valid then.
+            if (Workers::isOutdated(m_sequence)) {
+                break;
+            }
 
             for (size_t i = 0; i < N; ++i) {
                 if (*reinterpret_cast<uint64_t*>(m_hash + (i * 32) + 24) < m_state.job.target()) {
@@ -138,7 +176,11 @@ void MultiWorker<N>::start()
 
             m_count += N;
 
-            std::this_thread::yield();
+            const uint32_t interval = Workers::yieldInterval();
+            if (interval && ++m_rounds >= interval) {
+                m_rounds = 0;
+                std::this_thread::yield();
+            }
         }
 
         consumeJob();
@@ -158,24 +200,57 @@ bool MultiWorker<N>::resume(const xmrig::Job &job)
 }
 
 
+template<size_t N>
+bool MultiWorker<N>::setAlgorithm(xmrig::Algo algorithm)
+{
+    if (algorithm == m_algorithm) {
+        return true;
+    }
+
+    if (!Mem::carve(m_ctx, algorithm, N, m_memory)) {
+        return false;
+    }
+
+    m_algorithm = algorithm;
+    return true;
+}
+
+
 template<size_t N>
 bool MultiWorker<N>::verify(xmrig::Variant variant, const uint8_t *referenceValue)
 {
 
-    xmrig::CpuThread::cn_hash_fun func = m_thread->fn(variant);
+    xmrig::CpuThread::cn_hash_fun func = m_thread->fn(m_algorithm, variant);
     if (!func) {
         return false;
     }
 
-    func(test_input, 76, m_hash, m_ctx, 0);
-    return memcmp(m_hash, referenceValue, sizeof m_hash) == 0;
+    if (N <= kTestLanes) {
+        func(test_input, 76, m_hash, m_ctx, 0);
+        return memcmp(m_hash, referenceValue, sizeof m_hash) == 0;
+    }
+
+    // Test vectors cover 5 lanes, wider kernels get them repeated.
+    for (size_t k = 0; k < N; ++k) {
+        memcpy(m_state.blob + k * 76, test_input + (k % kTestLanes) * 76, 76);
+    }
+
+    func(m_state.blob, 76, m_hash, m_ctx, 0);
+
+    for (size_t k = 0; k < N; ++k) {
+        if (memcmp(m_hash + k * 32, referenceValue + (k % kTestLanes) * 32, 32) != 0) {
+            return false;
+        }
+    }
+
+    return true;
 }
 
 
 template<size_t N>
 bool MultiWorker<N>::verify2(xmrig::Variant variant, const uint8_t *referenceValue)
 {
-    xmrig::CpuThread::cn_hash_fun func = m_thread->fn(variant);
+    xmrig::CpuThread::cn_hash_fun func = m_thread->fn(m_algorithm, variant);
     if (!func) {
         return false;
     }
@@ -202,7 +277,7 @@ bool MultiWorker<N>::verify2(xmrig::Variant variant, const uint8_t *referenceVal
 template<>
 bool MultiWorker<1>::verify2(xmrig::Variant variant, const uint8_t *referenceValue)
 {
-    xmrig::CpuThread::cn_hash_fun func = m_thread->fn(variant);
+    xmrig::CpuThread::cn_hash_fun func = m_thread->fn(m_algorithm, variant);
     if (!func) {
         return false;
     }
@@ -222,8 +297,15 @@ bool MultiWorker<1>::verify2(xmrig::Variant variant, const uint8_t *referenceVal
 template<size_t N>
 void MultiWorker<N>::consumeJob()
 {
-    xmrig::Job job = Workers::job();
+    // Sequence first: setJob() publishes the job before it bumps the sequence, so the job is at least that new.
     m_sequence = Workers::sequence();
+    xmrig::Job job = Workers::job(m_id);
+
+    for (size_t i = 0; i < N; ++i) {
+        m_ctx[i]->abort    = Workers::sequenceRef();
+        m_ctx[i]->sequence = m_sequence;
+    }
+
     if (m_state.job == job) {
         return;
     }
@@ -231,10 +313,12 @@ void MultiWorker<N>::consumeJob()
     save(job);
 
     if (resume(job)) {
+        setAlgorithm(m_state.job.algorithm().algo());
         return;
     }
 
     m_state.job = job;
+    setAlgorithm(m_state.job.algorithm().algo());
 
     const size_t size = m_state.job.size();
     memcpy(m_state.blob, m_state.job.blob(), m_state.job.size());
@@ -270,3 +354,5 @@ template class MultiWorker<2>;
 template class MultiWorker<3>;
 template class MultiWorker<4>;
 template class MultiWorker<5>;
+template class MultiWorker<8>;
+template class MultiWorker<16>;
@@ -49,6 +49,8 @@ protected:
 
 private:
     bool resume(const xmrig::Job &job);
+    bool selfTest(xmrig::Algo algorithm);
+    bool setAlgorithm(xmrig::Algo algorithm);
     bool verify(xmrig::Variant variant, const uint8_t *referenceValue);
     bool verify2(xmrig::Variant variant, const uint8_t *referenceValue);
     void consumeJob();
@@ -68,7 +70,9 @@ private:
 
     cryptonight_ctx *m_ctx[N];
     State m_pausedState;
+    xmrig::Algo m_algorithm;
     State m_state;
+    uint32_t m_rounds;
     uint8_t m_hash[N * 32];
 };
 
@@ -0,0 +1,93 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2016-2018 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "workers/ResultQueue.h"
+
+
+static_assert((ResultQueue::kSize & (ResultQueue::kSize - 1)) == 0, "ResultQueue::kSize must be a power of two");
+
+
+ResultQueue::ResultQueue() :
+    m_head(0),
+    m_tail(0)
+{
+    for (size_t i = 0; i < kSize; ++i) {
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+
+/**
+ * Consumer side, only called from the libuv thread.
+ */
+bool ResultQueue::pop(xmrig::JobResult &result, uint64_t &timestamp)
+{
+    Slot &slot = m_slots[m_tail & (kSize - 1)];
+
+    if (slot.sequence.load(std::memory_order_acquire) != m_tail + 1) {
+        return false;
+    }
+
+    result    = slot.result;
+    timestamp = slot.timestamp;
+
+    slot.sequence.store(m_tail + kSize, std::memory_order_release);
+    m_tail++;
+
+    return true;
+}
+
+
+/**
+ * A slot is free for position pos when its sequence equals pos, producers race for the position with a CAS on
+ * the head and publish the slot by moving its sequence to pos + 1. Returns false when the ring is full.
+ */
+bool ResultQueue::push(const xmrig::JobResult &result, uint64_t timestamp)
+{
+    uint64_t pos = m_head.load(std::memory_order_relaxed);
+    Slot *slot   = nullptr;
+
+    for (;;) {
+        slot = &m_slots[pos & (kSize - 1)];
+
+        const int64_t diff = static_cast<int64_t>(slot->sequence.load(std::memory_order_acquire) - pos);
+        if (diff == 0) {
+            if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            return false;
+        }
+        else {
+            pos = m_head.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->result    = result;
+    slot->timestamp = timestamp;
+    slot->sequence.store(pos + 1, std::memory_order_release);
+
+    return true;
+}
@@ -0,0 +1,64 @@
+/* XMRig
+ * Copyright 2010      Jeff Garzik <jgarzik@pobox.com>
+ * Copyright 2012-2014 pooler      <pooler@litecoinpool.org>
+ * Copyright 2014      Lucas Jones <https://github.com/lucasjones>
+ * Copyright 2014-2016 Wolf9466    <https://github.com/OhGodAPet>
+ * Copyright 2016      Jay D Dee   <jayddee246@gmail.com>
+ * Copyright 2017-2018 XMR-Stak    <https://github.com/fireice-uk>, <https://github.com/psychocrypt>
+ * Copyright 2016-2018 XMRig       <https://github.com/xmrig>, <support@xmrig.com>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef XMRIG_RESULTQUEUE_H
+#define XMRIG_RESULTQUEUE_H
+
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+
+#include "net/JobResult.h"
+
+
+/**
+ * Bounded multi-producer single-consumer ring of preallocated result slots. Workers push found shares without
+ * locking or allocating, the libuv thread pops them. Each slot keeps the time its result was pushed.
+ */
+class ResultQueue
+{
+public:
+    static constexpr const size_t kSize = 256;
+
+    ResultQueue();
+
+    bool pop(xmrig::JobResult &result, uint64_t &timestamp);
+    bool push(const xmrig::JobResult &result, uint64_t timestamp);
+
+private:
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence;
+        uint64_t timestamp;
+        xmrig::JobResult result;
+    };
+
+    alignas(64) std::atomic<uint64_t> m_head;
+    alignas(64) uint64_t m_tail;
+    alignas(64) Slot m_slots[kSize];
+};
+
+
+#endif /* XMRIG_RESULTQUEUE_H */
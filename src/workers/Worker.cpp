@@ -25,6 +25,7 @@
 
 
 #include "common/cpu/Cpu.h"
+#include "common/cpu/Numa.h"
 #include "common/Platform.h"
 #include "workers/CpuThread.h"
 #include "workers/Handle.h"
@@ -43,6 +44,10 @@ Worker::Worker(Handle *handle) :
 {
     if (xmrig::Cpu::info()->threads() > 1 && m_thread->affinity() != -1L) {
         Platform::setThreadAffinity(m_thread->affinity());
+        xmrig::Numa::bindMemory(xmrig::Numa::node(m_thread->affinity()));
+    }
+    else if (xmrig::Numa::nodes() > 1) {
+        xmrig::Numa::bindThread(xmrig::Numa::nodeByIndex(m_id));
     }
 
     Platform::setThreadPriority(m_thread->priority());
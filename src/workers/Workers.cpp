@@ -22,16 +22,22 @@
  *   along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <cmath>
 #include <inttypes.h>
+#include <map>
 #include <thread>
 
 
 #include "api/Api.h"
+#include "common/cpu/Cpu.h"
 #include "common/log/Log.h"
 #include "core/Config.h"
 #include "core/Controller.h"
-#include "crypto/CryptoNight_constants.h"
+#include "crypto/CnRCache.h"
+#ifdef XMRIG_PPC64
+#   include "crypto/FastSqrt_ppc64.h"
+#endif
 #include "interfaces/IJobResultListener.h"
 #include "interfaces/IThread.h"
 #include "Mem.h"
@@ -46,25 +52,40 @@ bool Workers::m_active = false;
 bool Workers::m_enabled = true;
 Hashrate *Workers::m_hashrate = nullptr;
 xmrig::IJobResultListener *Workers::m_listener = nullptr;
-xmrig::Job Workers::m_job;
-Workers::LaunchStatus Workers::m_status;
+std::atomic<const xmrig::Job *> Workers::m_job;
 std::atomic<int> Workers::m_paused;
+std::atomic<uint64_t> Workers::m_epoch;
+std::atomic<uint32_t> Workers::m_yield;
 std::atomic<uint64_t> Workers::m_sequence;
-std::list<xmrig::JobResult> Workers::m_queue;
+std::vector<Workers::RetiredJob> Workers::m_retired;
 std::vector<Handle*> Workers::m_workers;
+std::vector<xmrig::Algo> Workers::m_switch;
+uint32_t Workers::m_yieldInterval = 1;
+uint32_t Workers::m_yieldLoad     = 0;
 uint64_t Workers::m_ticks = 0;
+Workers::JobEpoch *Workers::m_epochs = nullptr;
+Workers::LaunchStatus Workers::m_status;
+Workers::ResultLatency Workers::m_latency;
+ResultQueue Workers::m_results;
 uv_async_t Workers::m_async;
+uv_cond_t Workers::m_parkCond;
 uv_mutex_t Workers::m_mutex;
-uv_rwlock_t Workers::m_rwlock;
+uv_mutex_t Workers::m_parkMutex;
 uv_timer_t Workers::m_timer;
 xmrig::Controller *Workers::m_controller = nullptr;
 
 
-xmrig::Job Workers::job()
+/**
+ * Wait-free: the worker announces the current epoch in its own slot, copies the published snapshot and leaves.
+ * setJob() never frees a snapshot while a slot holds an epoch older than the one it was retired in.
+ */
+xmrig::Job Workers::job(size_t threadId)
 {
-    uv_rwlock_rdlock(&m_rwlock);
-    xmrig::Job job = m_job;
-    uv_rwlock_rdunlock(&m_rwlock);
+    std::atomic<uint64_t> &slot = m_epochs[threadId].epoch;
+
+    slot.store(m_epoch.load());
+    xmrig::Job job = *m_job.load();
+    slot.store(0, std::memory_order_release);
 
     return job;
 }
@@ -90,6 +111,46 @@ size_t Workers::threads()
 }
 
 
+/**
+ * Blocks the calling worker while mining is paused, setJob(), setEnabled() and stop() wake it.
+ */
+void Workers::park()
+{
+    uv_mutex_lock(&m_parkMutex);
+
+    while (isPaused()) {
+        uv_cond_wait(&m_parkCond, &m_parkMutex);
+    }
+
+    uv_mutex_unlock(&m_parkMutex);
+}
+
+
+/**
+ * Blocks the calling worker until the sequence moves past the given one: a new job, a pause or stop.
+ */
+void Workers::park(uint64_t sequence)
+{
+    uv_mutex_lock(&m_parkMutex);
+
+    while (!isOutdated(sequence)) {
+        uv_cond_wait(&m_parkCond, &m_parkMutex);
+    }
+
+    uv_mutex_unlock(&m_parkMutex);
+}
+
+
+void Workers::pause()
+{
+    m_active = false;
+    m_paused = 1;
+    m_sequence++;
+
+    wake();
+}
+
+
 void Workers::printHashrate(bool detail)
 {
     assert(m_controller != nullptr);
@@ -136,18 +197,27 @@ void Workers::setEnabled(bool enabled)
 
     m_paused = enabled ? 0 : 1;
     m_sequence++;
+
+    wake();
 }
 
 
 void Workers::setJob(const xmrig::Job &job, bool donate)
 {
-    uv_rwlock_wrlock(&m_rwlock);
-    m_job = job;
+    xmrig::Job *next = new xmrig::Job(job);
 
     if (donate) {
-        m_job.setPoolId(-1);
+        next->setPoolId(-1);
     }
-    uv_rwlock_wrunlock(&m_rwlock);
+
+    RetiredJob retired;
+    retired.job   = m_job.exchange(next);
+    retired.epoch = m_epoch.fetch_add(1) + 1;
+
+    m_retired.push_back(retired);
+    reclaim();
+
+    xmrig::CnRCache::prepare(job.algorithm().variant(), job.height());
 
     m_active = true;
     if (!m_enabled) {
@@ -156,6 +226,8 @@ void Workers::setJob(const xmrig::Job &job, bool donate)
 
     m_sequence++;
     m_paused = 0;
+
+    wake();
 }
 
 
@@ -173,12 +245,20 @@ void Workers::start(xmrig::Controller *controller)
     xmrig::CpuThread::patchAsmVariants();
 #   endif
 
+#   ifdef XMRIG_PPC64
+    SqrtV2::select();
+#   endif
+
     m_controller = controller;
 
     const std::vector<xmrig::IThread *> &threads = controller->config()->threads();
     m_status.algo    = controller->config()->algorithm().algo();
+    m_switch         = controller->config()->switchAlgorithms();
     m_status.colors  = controller->config()->isColors();
+    m_yieldInterval  = controller->config()->yieldInterval();
+    m_yieldLoad      = controller->config()->yieldLoad();
     m_status.threads = threads.size();
+    m_status.memory.assign(threads.size(), MemInfo());
 
     for (const xmrig::IThread *thread : threads) {
        m_status.ways += thread->multiway();
@@ -187,7 +267,18 @@ void Workers::start(xmrig::Controller *controller)
     m_hashrate = new Hashrate(threads.size(), controller);
 
     uv_mutex_init(&m_mutex);
-    uv_rwlock_init(&m_rwlock);
+    uv_mutex_init(&m_parkMutex);
+    uv_cond_init(&m_parkCond);
+
+    m_epochs = new JobEpoch[threads.size()];
+    for (size_t i = 0; i < threads.size(); ++i) {
+        m_epochs[i].epoch = 0;
+    }
+
+    m_epoch = 1;
+    m_job   = new xmrig::Job();
+
+    updateYield();
 
     m_sequence = 1;
     m_paused   = 1;
@@ -219,17 +310,31 @@ void Workers::stop()
     m_paused   = 0;
     m_sequence = 0;
 
+    wake();
+
     for (size_t i = 0; i < m_workers.size(); ++i) {
         m_workers[i]->join();
     }
+
+    for (const RetiredJob &retired : m_retired) {
+        delete retired.job;
+    }
+
+    m_retired.clear();
+    delete m_job.exchange(nullptr);
 }
 
 
 void Workers::submit(const xmrig::JobResult &result)
 {
-    uv_mutex_lock(&m_mutex);
-    m_queue.push_back(result);
-    uv_mutex_unlock(&m_mutex);
+    // The ring only fills up when the libuv thread stalls, wait for it rather than lose the share.
+    while (!m_results.push(result, uv_hrtime())) {
+        if (m_sequence.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+
+        std::this_thread::yield();
+    }
 
     uv_async_send(&m_async);
 }
@@ -240,7 +345,8 @@ void Workers::threadsSummary(rapidjson::Document &doc)
 {
     uv_mutex_lock(&m_mutex);
     const uint64_t pages[2] = { m_status.hugePages, m_status.pages };
-    const uint64_t memory   = m_status.ways * xmrig::cn_select_memory(m_status.algo);
+    const std::vector<MemInfo> threads = m_status.memory;
+    const ResultLatency latency        = m_latency;
     uv_mutex_unlock(&m_mutex);
 
     auto &allocator = doc.GetAllocator();
@@ -249,8 +355,48 @@ void Workers::threadsSummary(rapidjson::Document &doc)
     hugepages.PushBack(pages[0], allocator);
     hugepages.PushBack(pages[1], allocator);
 
+    // The arenas are sized for the largest algorithm of --algo-switch, so report what was allocated.
+    uint64_t memory = 0;
+    rapidjson::Value pageTiers(rapidjson::kArrayType);
+    rapidjson::Value threadsPages(rapidjson::kArrayType);
+    for (const MemInfo &info : threads) {
+        memory += info.size;
+        pageTiers.PushBack(rapidjson::StringRef(Mem::tierName(info.tier)), allocator);
+
+        rapidjson::Value coverage(rapidjson::kArrayType);
+        coverage.PushBack(static_cast<uint64_t>(info.hugePages), allocator);
+        coverage.PushBack(static_cast<uint64_t>(info.pages), allocator);
+        threadsPages.PushBack(coverage, allocator);
+    }
+
+    std::map<int, std::pair<uint64_t, uint64_t> > nodes;
+    for (const MemInfo &info : threads) {
+        if (info.memory && info.node >= 0) {
+            nodes[info.node].first++;
+            nodes[info.node].second += info.size;
+        }
+    }
+
+    rapidjson::Value numa(rapidjson::kArrayType);
+    for (const auto &node : nodes) {
+        rapidjson::Value value(rapidjson::kObjectType);
+        value.AddMember("node",    node.first, allocator);
+        value.AddMember("threads", node.second.first, allocator);
+        value.AddMember("memory",  node.second.second, allocator);
+        numa.PushBack(value, allocator);
+    }
+
     doc.AddMember("hugepages", hugepages, allocator);
+    doc.AddMember("hugepages_threads", threadsPages, allocator);
+    doc.AddMember("pages", pageTiers, allocator);
     doc.AddMember("memory", memory, allocator);
+    doc.AddMember("numa", numa, allocator);
+
+    rapidjson::Value results(rapidjson::kObjectType);
+    results.AddMember("count",  latency.count, allocator);
+    results.AddMember("avg_us", latency.count ? latency.total / latency.count / 1000 : 0, allocator);
+    results.AddMember("max_us", latency.max / 1000, allocator);
+    doc.AddMember("results_latency", results, allocator);
 }
 #endif
 
@@ -282,6 +428,14 @@ void Workers::onReady(void *arg)
         worker = new MultiWorker<5>(handle);
         break;
 
+    case 8:
+        worker = new MultiWorker<8>(handle);
+        break;
+
+    case 16:
+        worker = new MultiWorker<16>(handle);
+        break;
+
     default:
         break;
     }
@@ -300,25 +454,27 @@ void Workers::onReady(void *arg)
 
 void Workers::onResult(uv_async_t *handle)
 {
-    std::list<xmrig::JobResult> results;
-
-    uv_mutex_lock(&m_mutex);
-    while (!m_queue.empty()) {
-        results.push_back(std::move(m_queue.front()));
-        m_queue.pop_front();
-    }
-    uv_mutex_unlock(&m_mutex);
+    xmrig::JobResult result;
+    uint64_t timestamp = 0;
 
-    for (auto result : results) {
+    while (m_results.pop(result, timestamp)) {
         m_listener->onJobResult(result);
-    }
 
-    results.clear();
+        const uint64_t latency = uv_hrtime() - timestamp;
+
+        uv_mutex_lock(&m_mutex);
+        m_latency.count++;
+        m_latency.total += latency;
+        m_latency.max    = std::max(m_latency.max, latency);
+        uv_mutex_unlock(&m_mutex);
+    }
 }
 
 
 void Workers::onTick(uv_timer_t *handle)
 {
+    updateYield();
+
     for (Handle *handle : m_workers) {
         if (!handle->worker()) {
             return;
@@ -333,6 +489,39 @@ void Workers::onTick(uv_timer_t *handle)
 }
 
 
+/**
+ * Frees the job snapshots no worker can still be reading, a worker that announced an epoch older than the one a
+ * snapshot was retired in may hold a pointer to it. Only called from the libuv thread.
+ */
+void Workers::reclaim()
+{
+    uint64_t oldest = UINT64_MAX;
+
+    for (size_t i = 0; i < m_status.threads; ++i) {
+        const uint64_t epoch = m_epochs[i].epoch.load();
+        if (epoch && epoch < oldest) {
+            oldest = epoch;
+        }
+    }
+
+    auto it = m_retired.begin();
+    while (it != m_retired.end() && it->epoch <= oldest) {
+        delete it->job;
+        ++it;
+    }
+
+    m_retired.erase(m_retired.begin(), it);
+}
+
+
+void Workers::wake()
+{
+    uv_mutex_lock(&m_parkMutex);
+    uv_cond_broadcast(&m_parkCond);
+    uv_mutex_unlock(&m_parkMutex);
+}
+
+
 void Workers::start(IWorker *worker)
 {
     const Worker *w = static_cast<const Worker *>(worker);
@@ -342,23 +531,75 @@ void Workers::start(IWorker *worker)
     m_status.pages     += w->memory().pages;
     m_status.hugePages += w->memory().hugePages;
 
-    if (m_status.started == m_status.threads) {
+    if (w->id() < m_status.memory.size()) {
+        m_status.memory[w->id()] = w->memory();
+    }
+
+    const bool ready = m_status.started == m_status.threads;
+
+    if (ready) {
         const double percent = (double) m_status.hugePages / m_status.pages * 100.0;
-        const size_t memory  = m_status.ways * xmrig::cn_select_memory(m_status.algo) / 1024;
+        size_t memory = 0;
+        size_t counts[MemInfo::TierMax] = { 0 };
+        for (const MemInfo &info : m_status.memory) {
+            counts[info.tier]++;
+            memory += info.size / 1024;
+        }
+
+        char tiers[64] = { 0 };
+        size_t size    = 0;
+        for (int i = MemInfo::TierMax - 1; i >= 0; --i) {
+            if (counts[i] && size < sizeof(tiers)) {
+                size += snprintf(tiers + size, sizeof(tiers) - size, "%s%s x%zu", size ? ", " : "", Mem::tierName(static_cast<MemInfo::Tier>(i)), counts[i]);
+            }
+        }
 
         if (m_status.colors) {
-            LOG_INFO(GREEN_BOLD("READY (CPU)") " threads " CYAN_BOLD("%zu(%zu)") " huge pages %s%zu/%zu %1.0f%%\x1B[0m memory " CYAN_BOLD("%zu KB") "",
+            LOG_INFO(GREEN_BOLD("READY (CPU)") " threads " CYAN_BOLD("%zu(%zu)") " huge pages %s%zu/%zu %1.0f%%\x1B[0m pages " CYAN_BOLD("%s") " memory " CYAN_BOLD("%zu KB") "",
                      m_status.threads, m_status.ways,
                      (m_status.hugePages == m_status.pages ? "\x1B[1;32m" : (m_status.hugePages == 0 ? "\x1B[1;31m" : "\x1B[1;33m")),
-                     m_status.hugePages, m_status.pages, percent, memory);
+                     m_status.hugePages, m_status.pages, percent, tiers, memory);
         }
         else {
-            LOG_INFO("READY (CPU) threads %zu(%zu) huge pages %zu/%zu %1.0f%% memory %zu KB",
-                     m_status.threads, m_status.ways, m_status.hugePages, m_status.pages, percent, memory);
+            LOG_INFO("READY (CPU) threads %zu(%zu) huge pages %zu/%zu %1.0f%% pages %s memory %zu KB",
+                     m_status.threads, m_status.ways, m_status.hugePages, m_status.pages, percent, tiers, memory);
+        }
+
+        for (size_t i = 0; i < m_status.memory.size(); ++i) {
+            const MemInfo &info = m_status.memory[i];
+            if (info.tier != MemInfo::TierTHP || info.hugePages == info.pages) {
+                continue;
+            }
+
+            LOG_WARN("thread #%zu received only %zu/%zu transparent huge pages", i, info.hugePages, info.pages);
         }
     }
 
     uv_mutex_unlock(&m_mutex);
 
+    // Every scratchpad file in use is locked now.
+    if (ready) {
+        Mem::removeStaleFiles();
+    }
+
     worker->start();
 }
+
+
+/**
+ * Workers yield the CPU every m_yieldInterval hash rounds. With a load threshold they yield only while processes
+ * other than the miner keep more than that share of the logical CPUs busy.
+ */
+void Workers::updateYield()
+{
+    if (m_yieldLoad == 0) {
+        m_yield = m_yieldInterval;
+        return;
+    }
+
+    double load[3] = { 0.0 };
+    uv_loadavg(load);
+
+    const double others = load[0] - static_cast<double>(m_status.threads);
+    m_yield = others * 100.0 > static_cast<double>(m_yieldLoad * xmrig::Cpu::info()->threads()) ? m_yieldInterval : 0;
+}
@@ -27,13 +27,14 @@
 
 
 #include <atomic>
-#include <list>
 #include <uv.h>
 #include <vector>
 
 #include "common/net/Job.h"
+#include "Mem.h"
 #include "net/JobResult.h"
 #include "rapidjson/fwd.h"
+#include "workers/ResultQueue.h"
 
 
 class Handle;
@@ -50,9 +51,12 @@ namespace xmrig {
 class Workers
 {
 public:
-    static xmrig::Job job();
+    static xmrig::Job job(size_t threadId);
     static size_t hugePages();
     static size_t threads();
+    static void park();
+    static void park(uint64_t sequence);
+    static void pause();
     static void printHashrate(bool detail);
     static void setEnabled(bool enabled);
     static void setJob(const xmrig::Job &job, bool donate);
@@ -63,9 +67,11 @@ public:
     static inline bool isEnabled()                                      { return m_enabled; }
     static inline bool isOutdated(uint64_t sequence)                    { return m_sequence.load(std::memory_order_relaxed) != sequence; }
     static inline bool isPaused()                                       { return m_paused.load(std::memory_order_relaxed) == 1; }
+    static inline const std::vector<xmrig::Algo> &switchAlgorithms()    { return m_switch; }
+    static inline const std::atomic<uint64_t> *sequenceRef()            { return &m_sequence; }
     static inline Hashrate *hashrate()                                  { return m_hashrate; }
+    static inline uint32_t yieldInterval()                              { return m_yield.load(std::memory_order_relaxed); }
     static inline uint64_t sequence()                                   { return m_sequence.load(std::memory_order_relaxed); }
-    static inline void pause()                                          { m_active = false; m_paused = 1; m_sequence++; }
     static inline void setListener(xmrig::IJobResultListener *listener) { m_listener = listener; }
 
 #   ifndef XMRIG_NO_API
@@ -76,7 +82,23 @@ private:
     static void onReady(void *arg);
     static void onResult(uv_async_t *handle);
     static void onTick(uv_timer_t *handle);
+    static void reclaim();
+    static void wake();
     static void start(IWorker *worker);
+    static void updateYield();
+
+    // Epoch a worker announced while it reads the current job, 0 when it is not reading, padded to a cache line.
+    struct JobEpoch
+    {
+        std::atomic<uint64_t> epoch;
+        char pad[64 - sizeof(std::atomic<uint64_t>)];
+    };
+
+    struct RetiredJob
+    {
+        const xmrig::Job *job;
+        uint64_t epoch;
+    };
 
     class LaunchStatus
     {
@@ -97,23 +119,48 @@ private:
         size_t started;
         size_t threads;
         size_t ways;
+        std::vector<MemInfo> memory;
         xmrig::Algo algo;
     };
 
+    // Time from a worker pushing a result to the listener having sent it, in nanoseconds.
+    class ResultLatency
+    {
+    public:
+        inline ResultLatency() :
+            count(0),
+            max(0),
+            total(0)
+        {}
+
+        uint64_t count;
+        uint64_t max;
+        uint64_t total;
+    };
+
     static bool m_active;
     static bool m_enabled;
     static Hashrate *m_hashrate;
     static xmrig::IJobResultListener *m_listener;
-    static xmrig::Job m_job;
+    static JobEpoch *m_epochs;
     static LaunchStatus m_status;
+    static ResultLatency m_latency;
+    static ResultQueue m_results;
+    static std::atomic<const xmrig::Job *> m_job;
     static std::atomic<int> m_paused;
+    static std::atomic<uint64_t> m_epoch;
+    static std::atomic<uint32_t> m_yield;
     static std::atomic<uint64_t> m_sequence;
-    static std::list<xmrig::JobResult> m_queue;
+    static std::vector<RetiredJob> m_retired;
     static std::vector<Handle*> m_workers;
+    static std::vector<xmrig::Algo> m_switch;
+    static uint32_t m_yieldInterval;
+    static uint32_t m_yieldLoad;
     static uint64_t m_ticks;
     static uv_async_t m_async;
+    static uv_cond_t m_parkCond;
     static uv_mutex_t m_mutex;
-    static uv_rwlock_t m_rwlock;
+    static uv_mutex_t m_parkMutex;
     static uv_timer_t m_timer;
     static xmrig::Controller *m_controller;
 };